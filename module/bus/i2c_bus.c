@@ -0,0 +1,312 @@
+/**
+ * @file i2c_bus.c
+ * @brief Non-blocking I2C transactions, requester task sleeps until completion or timeout
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "i2c_bus.h"
+#include "i2c_supervisor.h"
+#include "monotime.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+
+typedef struct {
+    osThreadId_t thread;
+    i2c_priority_t priority;
+    uint32_t ticket;            /**< Arrival order */
+} i2c_bus_requester_t;
+
+/**
+ * @brief Status of the last transfer of one task, tasks sharing a bus classify only their own failures
+ */
+typedef struct {
+    osThreadId_t thread;
+    i2c_status_t status;
+} i2c_bus_caller_t;
+
+typedef struct {
+    osMutexId_t lock;           /**< Guards arbitration state, held only for bookkeeping */
+    bool owned;
+    uint64_t granted_us;
+    uint32_t next_ticket;
+    i2c_bus_requester_t queue[I2C_BUS_MAX_WAITERS];
+    osThreadId_t volatile waiter;
+    volatile i2c_status_t status;
+    i2c_bus_caller_t callers[I2C_BUS_MAX_WAITERS];
+    uint8_t caller_count;
+    i2c_bus_stats_t stats;
+    uint64_t reported_us;
+    uint64_t reported_busy_us;
+} i2c_bus_state_t;
+
+i2c_bus_driver_t i2c_bus;
+static i2c_bus_state_t bus_states[I2C_BUS_COUNT];
+
+static uint32_t ms_to_ticks(uint32_t ms) {
+    return (ms * osKernelGetTickFreq() + 999) / 1000;
+}
+
+void i2c_bus_init(void) {
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        bus_states[bus].lock = osMutexNew(NULL);
+        bus_states[bus].waiter = NULL;
+    }
+    i2c_supervisor_init();
+    i2c_bus_init_driver();
+}
+
+/**
+ * @brief Removes requester from bus queue
+ *
+ * @return false - requester is not queued
+ */
+static bool i2c_bus_dequeue(i2c_bus_state_t* state, osThreadId_t thread) {
+    for (uint8_t i = 0; i < state->stats.queue_depth; i++) {
+        if (state->queue[i].thread != thread) {
+            continue;
+        }
+        for (uint8_t j = i + 1; j < state->stats.queue_depth; j++) {
+            state->queue[j - 1] = state->queue[j];
+        }
+        state->stats.queue_depth--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Records status of the last transfer of the calling task
+ * @note Table holds as many tasks as may queue for the bus, the last slot is reused beyond that
+ */
+static void i2c_bus_record_status(i2c_bus_state_t* state, i2c_status_t status) {
+    osThreadId_t thread = osThreadGetId();
+    osMutexAcquire(state->lock, osWaitForever);
+    uint8_t i = 0;
+    while (i < state->caller_count && state->callers[i].thread != thread) {
+        i++;
+    }
+    if (i == state->caller_count) {
+        if (state->caller_count < I2C_BUS_MAX_WAITERS) {
+            state->caller_count++;
+        } else {
+            i = I2C_BUS_MAX_WAITERS - 1;
+        }
+        state->callers[i].thread = thread;
+    }
+    state->callers[i].status = status;
+    osMutexRelease(state->lock);
+}
+
+/**
+ * @brief Takes the bus if it is free, otherwise queues and sleeps until the bus is handed over
+ *
+ * @return false - bus was not granted within timeout
+ */
+static bool i2c_bus_acquire(i2c_bus_state_t* state, i2c_priority_t priority, uint32_t timeout) {
+    uint64_t start_us = monotime_now_us();
+    osMutexAcquire(state->lock, osWaitForever);
+    if (!state->owned) {
+        state->owned = true;
+        state->granted_us = start_us;
+        state->stats.grants++;
+        osMutexRelease(state->lock);
+        return true;
+    }
+    if (state->stats.queue_depth >= I2C_BUS_MAX_WAITERS) {
+        osMutexRelease(state->lock);
+        return false;
+    }
+    osThreadFlagsClear(I2C_BUS_GRANT_FLAG);
+    state->queue[state->stats.queue_depth++] = (i2c_bus_requester_t){osThreadGetId(), priority, state->next_ticket++};
+    if (state->stats.queue_depth > state->stats.queue_max) {
+        state->stats.queue_max = state->stats.queue_depth;
+    }
+    osMutexRelease(state->lock);
+
+    bool granted = (osThreadFlagsWait(I2C_BUS_GRANT_FLAG, osFlagsWaitAny, timeout) & osFlagsError) == 0;
+    osMutexAcquire(state->lock, osWaitForever);
+    if (!granted) {
+        /* Hand-over may have raced with the timeout, the bus is ours once we are off the queue */
+        granted = !i2c_bus_dequeue(state, osThreadGetId());
+        osThreadFlagsClear(I2C_BUS_GRANT_FLAG);
+    }
+    if (granted) {
+        state->stats.grants++;
+        uint32_t wait_us = (uint32_t)(monotime_now_us() - start_us);
+        state->stats.wait_us += wait_us;
+        if (wait_us > state->stats.wait_max_us) {
+            state->stats.wait_max_us = wait_us;
+        }
+    }
+    osMutexRelease(state->lock);
+    return granted;
+}
+
+/**
+ * @brief Hands the bus over to the most urgent queued requester, the earliest one among equals
+ */
+static void i2c_bus_release(i2c_bus_state_t* state) {
+    osMutexAcquire(state->lock, osWaitForever);
+    uint64_t now_us = monotime_now_us();
+    state->stats.busy_us += now_us - state->granted_us;
+
+    int next = -1;
+    for (int i = 0; i < state->stats.queue_depth; i++) {
+        const i2c_bus_requester_t* requester = &state->queue[i];
+        if (next < 0 || requester->priority > state->queue[next].priority ||
+            (requester->priority == state->queue[next].priority && (int32_t)(requester->ticket - state->queue[next].ticket) < 0)) {
+            next = i;
+        }
+    }
+    if (next >= 0) {
+        for (int i = 0; i < state->stats.queue_depth; i++) {
+            if ((int32_t)(state->queue[i].ticket - state->queue[next].ticket) < 0) {
+                state->stats.overtakes++;
+                break;
+            }
+        }
+        osThreadId_t thread = state->queue[next].thread;
+        i2c_bus_dequeue(state, thread);
+        state->granted_us = now_us;
+        osThreadFlagsSet(thread, I2C_BUS_GRANT_FLAG);
+    } else {
+        state->owned = false;
+    }
+    osMutexRelease(state->lock);
+}
+
+i2c_status_t i2c_bus_transfer(const i2c_transaction_t* transaction) {
+    i2c_bus_state_t* state = &bus_states[transaction->bus];
+    uint32_t timeout = ms_to_ticks(transaction->timeout_ms);
+
+    if (!i2c_supervisor_admit(transaction->bus, transaction->addr)) {
+        i2c_bus_record_status(state, I2C_STATUS_ISOLATED);
+        return I2C_STATUS_ISOLATED;
+    }
+    if (!i2c_bus_acquire(state, transaction->priority, timeout)) {
+        i2c_bus_record_status(state, I2C_STATUS_BUSY);
+        return I2C_STATUS_BUSY;
+    }
+
+    /* Completion of an earlier timed out transfer may have left the flag set */
+    osThreadFlagsClear(I2C_BUS_THREAD_FLAG);
+    state->status = I2C_STATUS_BUSY;
+    state->waiter = osThreadGetId();
+
+    i2c_status_t status;
+    if (!i2c_bus.start(transaction)) {
+        status = I2C_STATUS_ERROR;
+    } else if (osThreadFlagsWait(I2C_BUS_THREAD_FLAG, osFlagsWaitAny, timeout) == (uint32_t)osFlagsErrorTimeout) {
+        SLOG_WARN("i2c bus %u: device 0x%02X timed out", transaction->bus, transaction->addr);
+        i2c_bus.abort(transaction->bus);
+        status = I2C_STATUS_TIMEOUT;
+    } else {
+        status = state->status;
+    }
+
+    state->waiter = NULL;
+    i2c_bus_record_status(state, status);
+    osMutexAcquire(state->lock, osWaitForever);
+    state->stats.transactions++;
+    if (status == I2C_STATUS_OK) {
+        state->stats.bytes += transaction->len;
+    } else {
+        state->stats.failures++;
+    }
+    osMutexRelease(state->lock);
+    i2c_supervisor_account(transaction->bus, transaction->addr, status);
+    i2c_bus_release(state);
+    return status;
+}
+
+i2c_status_t i2c_bus_transmit(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, const uint8_t* data, uint16_t len) {
+    i2c_transaction_t transaction = {
+        .bus = bus, .priority = priority, .op = I2C_OP_TRANSMIT, .addr = addr, .data = (uint8_t*)data, .len = len, .timeout_ms = I2C_BUS_TIMEOUT_MS,
+    };
+    return i2c_bus_transfer(&transaction);
+}
+
+i2c_status_t i2c_bus_receive(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t* data, uint16_t len) {
+    i2c_transaction_t transaction = {
+        .bus = bus, .priority = priority, .op = I2C_OP_RECEIVE, .addr = addr, .data = data, .len = len, .timeout_ms = I2C_BUS_TIMEOUT_MS,
+    };
+    return i2c_bus_transfer(&transaction);
+}
+
+i2c_status_t i2c_bus_mem_write(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t reg, const uint8_t* data, uint16_t len) {
+    i2c_transaction_t transaction = {
+        .bus = bus, .priority = priority, .op = I2C_OP_MEM_WRITE, .addr = addr, .reg = reg, .data = (uint8_t*)data, .len = len, .timeout_ms = I2C_BUS_TIMEOUT_MS,
+    };
+    return i2c_bus_transfer(&transaction);
+}
+
+i2c_status_t i2c_bus_mem_read(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t reg, uint8_t* data, uint16_t len) {
+    i2c_transaction_t transaction = {
+        .bus = bus, .priority = priority, .op = I2C_OP_MEM_READ, .addr = addr, .reg = reg, .data = data, .len = len, .timeout_ms = I2C_BUS_TIMEOUT_MS,
+    };
+    return i2c_bus_transfer(&transaction);
+}
+
+bool i2c_bus_probe(i2c_bus_id_t bus, uint8_t addr, uint32_t trials) {
+    i2c_bus_state_t* state = &bus_states[bus];
+    if (!i2c_supervisor_admit(bus, addr)) {
+        return false;
+    }
+    if (!i2c_bus_acquire(state, I2C_PRIORITY_LOW, ms_to_ticks(I2C_BUS_TIMEOUT_MS))) {
+        return false;
+    }
+    bool present = i2c_bus.probe(bus, addr, trials);
+    i2c_bus_release(state);
+    return present;
+}
+
+i2c_status_t i2c_bus_last_status(i2c_bus_id_t bus) {
+    i2c_bus_state_t* state = &bus_states[bus];
+    osThreadId_t thread = osThreadGetId();
+    i2c_status_t status = I2C_STATUS_OK;
+    osMutexAcquire(state->lock, osWaitForever);
+    for (uint8_t i = 0; i < state->caller_count; i++) {
+        if (state->callers[i].thread == thread) {
+            status = state->callers[i].status;
+            break;
+        }
+    }
+    osMutexRelease(state->lock);
+    return status;
+}
+
+void i2c_bus_get_stats(i2c_bus_id_t bus, i2c_bus_stats_t* stats) {
+    i2c_bus_state_t* state = &bus_states[bus];
+    osMutexAcquire(state->lock, osWaitForever);
+    *stats = state->stats;
+    osMutexRelease(state->lock);
+}
+
+void i2c_bus_report(void) {
+    uint64_t now_us = monotime_now_us();
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        i2c_bus_state_t* state = &bus_states[bus];
+        i2c_bus_stats_t stats;
+        i2c_bus_get_stats(bus, &stats);
+
+        uint64_t elapsed_us = now_us - state->reported_us;
+        uint32_t busy_permille = (elapsed_us > 0) ? (uint32_t)((stats.busy_us - state->reported_busy_us) * 1000 / elapsed_us) : 0;
+        uint32_t wait_avg_us = (stats.grants > 0) ? (uint32_t)(stats.wait_us / stats.grants) : 0;
+        SLOG_INFO("i2c bus %u: busy %lu.%lu%% transfers %lu failed %lu bytes %lu", bus, busy_permille / 10,
+            busy_permille % 10, stats.transactions, stats.failures, stats.bytes);
+        SLOG_INFO("i2c bus %u: grants %lu wait avg %luus max %luus queue %u max %u overtakes %lu", bus, stats.grants,
+            wait_avg_us, stats.wait_max_us, stats.queue_depth, stats.queue_max, stats.overtakes);
+        state->reported_us = now_us;
+        state->reported_busy_us = stats.busy_us;
+    }
+}
+
+void i2c_bus_complete_handler(i2c_bus_id_t bus, bool success) {
+    i2c_bus_state_t* state = &bus_states[bus];
+    state->status = success ? I2C_STATUS_OK : I2C_STATUS_ERROR;
+    osThreadId_t waiter = state->waiter;
+    if (waiter != NULL) {
+        osThreadFlagsSet(waiter, I2C_BUS_THREAD_FLAG);
+    }
+}
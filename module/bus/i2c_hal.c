@@ -0,0 +1,131 @@
+/**
+ * @file i2c_hal.c
+ * @brief I2C bus driver on top of HAL interrupt transfers
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "i2c_sim.h"
+
+#if !I2C_SIM_ENABLED
+
+#include "i2c_bus.h"
+#include "slog.h"
+#include "monotime.h"
+#include "i2c.h"
+#include "main.h"
+
+#define I2C_HAL_PROBE_TIMEOUT_MS 5
+#define I2C_HAL_RECOVERY_CLOCKS  9   /**< Enough for a slave to shift out the rest of a byte and its ACK */
+#define I2C_HAL_RECOVERY_HALF_PERIOD_US 5
+
+typedef struct {
+    GPIO_TypeDef* port;
+    uint16_t sda;
+    uint16_t scl;
+} i2c_hal_pins_t;
+
+static I2C_HandleTypeDef* const bus_handles[I2C_BUS_COUNT] = {
+    [I2C_BUS_SENSORS] = &sens_i2c,
+    [I2C_BUS_TOUCH] = &touch_i2c,
+};
+
+/* Shall match pins configured in i2c.c MSP init */
+static const i2c_hal_pins_t bus_pins[I2C_BUS_COUNT] = {
+    [I2C_BUS_SENSORS] = {GPIOF, GPIO_PIN_0, GPIO_PIN_1},
+    [I2C_BUS_TOUCH] = {GPIOF, GPIO_PIN_15, GPIO_PIN_14},
+};
+
+static bool i2c_hal_start(const i2c_transaction_t* transaction) {
+    I2C_HandleTypeDef* handle = bus_handles[transaction->bus];
+    uint16_t addr = (uint16_t)transaction->addr << 1;
+    HAL_StatusTypeDef result = HAL_ERROR;
+
+    switch (transaction->op) {
+    case I2C_OP_TRANSMIT:
+        result = HAL_I2C_Master_Transmit_IT(handle, addr, transaction->data, transaction->len);
+        break;
+    case I2C_OP_RECEIVE:
+        result = HAL_I2C_Master_Receive_IT(handle, addr, transaction->data, transaction->len);
+        break;
+    case I2C_OP_MEM_WRITE:
+        result = HAL_I2C_Mem_Write_IT(handle, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, transaction->data, transaction->len);
+        break;
+    case I2C_OP_MEM_READ:
+        result = HAL_I2C_Mem_Read_IT(handle, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, transaction->data, transaction->len);
+        break;
+    }
+    return result == HAL_OK;
+}
+
+static void i2c_hal_abort(i2c_bus_id_t bus) {
+    /* Peripheral re-initialization drops any transfer state left by the stuck transaction */
+    I2C_HandleTypeDef* handle = bus_handles[bus];
+    HAL_I2C_DeInit(handle);
+    if (HAL_I2C_Init(handle) != HAL_OK) {
+        SLOG_ERROR("i2c bus %u re-initialization failed", bus);
+    }
+}
+
+static bool i2c_hal_probe(i2c_bus_id_t bus, uint8_t addr, uint32_t trials) {
+    return HAL_I2C_IsDeviceReady(bus_handles[bus], (uint16_t)addr << 1, trials, I2C_HAL_PROBE_TIMEOUT_MS) == HAL_OK;
+}
+
+static bool i2c_hal_lines_released(i2c_bus_id_t bus) {
+    const i2c_hal_pins_t* pins = &bus_pins[bus];
+    return HAL_GPIO_ReadPin(pins->port, pins->sda) == GPIO_PIN_SET && HAL_GPIO_ReadPin(pins->port, pins->scl) == GPIO_PIN_SET;
+}
+
+static void i2c_hal_delay_us(uint32_t us) {
+    uint64_t end = monotime_now_us() + us;
+    while (monotime_now_us() < end) {
+    }
+}
+
+static bool i2c_hal_recover(i2c_bus_id_t bus) {
+    I2C_HandleTypeDef* handle = bus_handles[bus];
+    const i2c_hal_pins_t* pins = &bus_pins[bus];
+
+    /* Take lines over from the peripheral as open-drain outputs, reading them returns the real level */
+    HAL_I2C_DeInit(handle);
+    HAL_GPIO_WritePin(pins->port, pins->sda | pins->scl, GPIO_PIN_SET);
+    GPIO_InitTypeDef gpio = {
+        .Pin = pins->sda | pins->scl, .Mode = GPIO_MODE_OUTPUT_OD, .Pull = GPIO_PULLUP, .Speed = GPIO_SPEED_FREQ_LOW,
+    };
+    HAL_GPIO_Init(pins->port, &gpio);
+
+    for (uint8_t i = 0; i < I2C_HAL_RECOVERY_CLOCKS && HAL_GPIO_ReadPin(pins->port, pins->sda) == GPIO_PIN_RESET; i++) {
+        HAL_GPIO_WritePin(pins->port, pins->scl, GPIO_PIN_RESET);
+        i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+        HAL_GPIO_WritePin(pins->port, pins->scl, GPIO_PIN_SET);
+        i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+    }
+
+    /* STOP condition, SDA rises while SCL is high */
+    HAL_GPIO_WritePin(pins->port, pins->scl, GPIO_PIN_RESET);
+    i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+    HAL_GPIO_WritePin(pins->port, pins->sda, GPIO_PIN_RESET);
+    i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+    HAL_GPIO_WritePin(pins->port, pins->scl, GPIO_PIN_SET);
+    i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+    HAL_GPIO_WritePin(pins->port, pins->sda, GPIO_PIN_SET);
+    i2c_hal_delay_us(I2C_HAL_RECOVERY_HALF_PERIOD_US);
+    bool released = HAL_GPIO_ReadPin(pins->port, pins->sda) == GPIO_PIN_SET && HAL_GPIO_ReadPin(pins->port, pins->scl) == GPIO_PIN_SET;
+
+    /* MSP init restores alternate function of the pins */
+    HAL_GPIO_DeInit(pins->port, pins->sda | pins->scl);
+    if (HAL_I2C_Init(handle) != HAL_OK) {
+        SLOG_ERROR("i2c bus %u re-initialization failed", bus);
+    }
+    return released;
+}
+
+void i2c_bus_init_driver(void) {
+    i2c_bus.start = i2c_hal_start;
+    i2c_bus.abort = i2c_hal_abort;
+    i2c_bus.probe = i2c_hal_probe;
+    i2c_bus.lines_released = i2c_hal_lines_released;
+    i2c_bus.recover = i2c_hal_recover;
+}
+
+#endif /* !I2C_SIM_ENABLED */
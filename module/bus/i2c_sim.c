@@ -0,0 +1,138 @@
+/**
+ * @file i2c_sim.c
+ * @brief Simulated I2C bus driver, devices are register-level models running in virtual time
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "i2c_sim.h"
+
+#if I2C_SIM_ENABLED
+
+#include "slog.h"
+#include "cmsis_os2.h"
+#include <string.h>
+
+static i2c_sim_device_t* devices[I2C_SIM_MAX_DEVICES];
+static uint8_t device_count = 0;
+static uint32_t time_scale = I2C_SIM_TIME_SCALE;
+static bool sda_held[I2C_BUS_COUNT];
+
+void i2c_sim_add_device(i2c_sim_device_t* device) {
+    if (device_count >= I2C_SIM_MAX_DEVICES) {
+        SLOG_ERROR("i2c sim: no room for device 0x%02X", device->addr);
+        return;
+    }
+    devices[device_count++] = device;
+}
+
+void i2c_sim_set_time_scale(uint32_t scale) {
+    time_scale = (scale > 0) ? scale : 1;
+}
+
+uint64_t i2c_sim_time_ms(void) {
+    return (uint64_t)osKernelGetTickCount() * 1000 / osKernelGetTickFreq() * time_scale;
+}
+
+bool i2c_sim_fault_hits(const i2c_sim_device_t* device, uint16_t every) {
+    return every > 0 && device->transactions % every == 0;
+}
+
+static i2c_sim_device_t* i2c_sim_find(i2c_bus_id_t bus, uint8_t addr) {
+    for (uint8_t i = 0; i < device_count; i++) {
+        if (devices[i]->bus == bus && devices[i]->addr == addr && devices[i]->attached) {
+            return devices[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs transaction against device model
+ *
+ * @return false - device did not acknowledge
+ */
+static bool i2c_sim_execute(i2c_sim_device_t* device, const i2c_transaction_t* transaction) {
+    if (i2c_sim_fault_hits(device, device->faults.nack_every)) {
+        return false;
+    }
+
+    uint8_t buffer[I2C_SIM_MAX_WRITE];
+    switch (transaction->op) {
+    case I2C_OP_TRANSMIT:
+        device->write(device, transaction->data, transaction->len);
+        break;
+    case I2C_OP_RECEIVE:
+        device->read(device, transaction->data, transaction->len);
+        break;
+    case I2C_OP_MEM_WRITE:
+        if (transaction->len >= sizeof(buffer)) {
+            return false;
+        }
+        buffer[0] = transaction->reg;
+        memcpy(&buffer[1], transaction->data, transaction->len);
+        device->write(device, buffer, transaction->len + 1);
+        break;
+    case I2C_OP_MEM_READ:
+        device->write(device, &transaction->reg, 1);
+        device->read(device, transaction->data, transaction->len);
+        break;
+    }
+
+    bool is_read = transaction->op == I2C_OP_RECEIVE || transaction->op == I2C_OP_MEM_READ;
+    if (is_read && transaction->len > 0 && i2c_sim_fault_hits(device, device->faults.corrupt_every)) {
+        transaction->data[transaction->len - 1] ^= 0x01;
+    }
+    return true;
+}
+
+static bool i2c_sim_start(const i2c_transaction_t* transaction) {
+    i2c_sim_device_t* device = i2c_sim_find(transaction->bus, transaction->addr);
+    bool success = false;
+    if (sda_held[transaction->bus]) {
+        device = NULL;
+    } else if (device != NULL) {
+        device->transactions++;
+        if (i2c_sim_fault_hits(device, device->faults.hold_sda_every)) {
+            /* Device wedges in the middle of a byte, transfer never completes */
+            sda_held[transaction->bus] = true;
+            return true;
+        }
+        if (i2c_sim_fault_hits(device, device->faults.stall_every)) {
+            /* Completion is never reported, requester times out and aborts */
+            return true;
+        }
+        success = i2c_sim_execute(device, transaction);
+    }
+    /* Models respond immediately, completion is reported from requester context */
+    i2c_bus_complete_handler(transaction->bus, success);
+    return true;
+}
+
+static void i2c_sim_abort(i2c_bus_id_t bus) {
+}
+
+static bool i2c_sim_probe(i2c_bus_id_t bus, uint8_t addr, uint32_t trials) {
+    return !sda_held[bus] && i2c_sim_find(bus, addr) != NULL;
+}
+
+static bool i2c_sim_lines_released(i2c_bus_id_t bus) {
+    return !sda_held[bus];
+}
+
+static bool i2c_sim_recover(i2c_bus_id_t bus) {
+    /* Clocking always lets a simulated device finish its byte */
+    sda_held[bus] = false;
+    return true;
+}
+
+void i2c_bus_init_driver(void) {
+    i2c_bus.start = i2c_sim_start;
+    i2c_bus.abort = i2c_sim_abort;
+    i2c_bus.probe = i2c_sim_probe;
+    i2c_bus.lines_released = i2c_sim_lines_released;
+    i2c_bus.recover = i2c_sim_recover;
+    SLOG_INFO("i2c sim: virtual time x%lu", time_scale);
+}
+
+#endif /* I2C_SIM_ENABLED */
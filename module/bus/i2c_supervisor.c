@@ -0,0 +1,137 @@
+/**
+ * @file i2c_supervisor.c
+ * @brief Bus supervisor, recovers stuck lines and isolates repeatedly failing devices
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "i2c_supervisor.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+
+typedef struct {
+    uint8_t addr;
+    uint8_t failures;       /**< Consecutive failed transfers */
+    bool isolated;
+    uint32_t backoff_ms;
+    uint32_t isolated_until;    /**< Kernel tick of the next trial transfer */
+    uint32_t isolations;
+} i2c_device_health_t;
+
+typedef struct {
+    osMutexId_t lock;       /**< Guards device table, admit runs in requester tasks while account appends */
+    i2c_device_health_t devices[I2C_SUPERVISOR_MAX_DEVICES];
+    uint8_t device_count;
+    uint32_t stuck_detected;
+    uint32_t recoveries;    /**< Recoveries that released the lines */
+} i2c_bus_health_t;
+
+static i2c_bus_health_t bus_health[I2C_BUS_COUNT];
+
+static i2c_device_health_t* find_device(i2c_bus_id_t bus, uint8_t addr, bool create) {
+    i2c_bus_health_t* health = &bus_health[bus];
+    for (uint8_t i = 0; i < health->device_count; i++) {
+        if (health->devices[i].addr == addr) {
+            return &health->devices[i];
+        }
+    }
+    if (!create || health->device_count >= I2C_SUPERVISOR_MAX_DEVICES) {
+        return NULL;
+    }
+    i2c_device_health_t* device = &health->devices[health->device_count++];
+    device->addr = addr;
+    device->backoff_ms = I2C_SUPERVISOR_BACKOFF_MIN_MS;
+    return device;
+}
+
+void i2c_supervisor_init(void) {
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        bus_health[bus].lock = osMutexNew(NULL);
+    }
+}
+
+bool i2c_supervisor_admit(i2c_bus_id_t bus, uint8_t addr) {
+    osMutexAcquire(bus_health[bus].lock, osWaitForever);
+    const i2c_device_health_t* device = find_device(bus, addr, false);
+    bool admitted = (device == NULL || !device->isolated || (int32_t)(osKernelGetTickCount() - device->isolated_until) >= 0);
+    osMutexRelease(bus_health[bus].lock);
+    return admitted;
+}
+
+/**
+ * @brief Releases bus held by a device, a slave stuck in the middle of a byte keeps SDA low
+ */
+static void recover_lines(i2c_bus_id_t bus) {
+    if (i2c_bus.lines_released(bus)) {
+        return;
+    }
+    bus_health[bus].stuck_detected++;
+    if (i2c_bus.recover(bus)) {
+        bus_health[bus].recoveries++;
+        SLOG_WARN("i2c bus %u: stuck lines released", bus);
+    } else {
+        SLOG_ERROR("i2c bus %u: lines still held after recovery", bus);
+    }
+}
+
+void i2c_supervisor_account(i2c_bus_id_t bus, uint8_t addr, i2c_status_t status) {
+    osMutexId_t lock = bus_health[bus].lock;
+    if (status == I2C_STATUS_OK) {
+        osMutexAcquire(lock, osWaitForever);
+        i2c_device_health_t* device = find_device(bus, addr, false);
+        bool recovered = (device != NULL && device->isolated);
+        if (device != NULL) {
+            device->failures = 0;
+            device->isolated = false;
+            device->backoff_ms = I2C_SUPERVISOR_BACKOFF_MIN_MS;
+        }
+        osMutexRelease(lock);
+        if (recovered) {
+            SLOG_INFO("i2c bus %u: device 0x%02X recovered", bus, addr);
+        }
+        return;
+    }
+    if (status != I2C_STATUS_ERROR && status != I2C_STATUS_TIMEOUT) {
+        return;
+    }
+
+    recover_lines(bus);
+    osMutexAcquire(lock, osWaitForever);
+    i2c_device_health_t* device = find_device(bus, addr, true);
+    if (device == NULL || ++device->failures < I2C_SUPERVISOR_FAILURE_LIMIT) {
+        osMutexRelease(lock);
+        return;
+    }
+    if (device->isolated) {
+        /* Trial transfer after backoff failed as well */
+        device->backoff_ms *= 2;
+        if (device->backoff_ms > I2C_SUPERVISOR_BACKOFF_MAX_MS) {
+            device->backoff_ms = I2C_SUPERVISOR_BACKOFF_MAX_MS;
+        }
+    }
+    device->isolated = true;
+    device->isolations++;
+    device->isolated_until = osKernelGetTickCount() + device->backoff_ms * osKernelGetTickFreq() / 1000;
+    uint32_t backoff_ms = device->backoff_ms;
+    osMutexRelease(lock);
+    SLOG_WARN("i2c bus %u: device 0x%02X isolated for %lums", bus, addr, backoff_ms);
+}
+
+void i2c_supervisor_report(void) {
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        /* Copy is taken under lock, logging may block */
+        i2c_bus_health_t health;
+        osMutexAcquire(bus_health[bus].lock, osWaitForever);
+        health = bus_health[bus];
+        osMutexRelease(bus_health[bus].lock);
+        SLOG_INFO("i2c bus %u: stuck %lu recovered %lu", bus, health.stuck_detected, health.recoveries);
+        for (uint8_t i = 0; i < health.device_count; i++) {
+            const i2c_device_health_t* device = &health.devices[i];
+            int32_t left_ticks = device->isolated ? (int32_t)(device->isolated_until - now) : 0;
+            int32_t left_ms = (int32_t)((int64_t)left_ticks * 1000 / (int32_t)osKernelGetTickFreq());
+            SLOG_INFO("i2c bus %u: device 0x%02X failures %u isolations %lu, %s %ldms", bus, device->addr,
+                device->failures, device->isolations, device->isolated ? "isolated" : "admitted", (left_ms > 0) ? left_ms : 0);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ * @file i2c_bus.h
+ * @brief Non-blocking I2C transactions, requester task sleeps until completion or timeout
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define I2C_BUS_TIMEOUT_MS 50
+#define I2C_BUS_MAX_WAITERS 8   /**< Tasks queued for one bus */
+
+/** Thread flags used to signal transaction completion and bus grant, reserved in tasks that use the bus */
+#define I2C_BUS_THREAD_FLAG 0x8000
+#define I2C_BUS_GRANT_FLAG  0x4000
+
+typedef enum {
+    I2C_BUS_SENSORS,
+    I2C_BUS_TOUCH,
+    I2C_BUS_COUNT
+} i2c_bus_id_t;
+
+typedef enum {
+    I2C_STATUS_OK,
+    I2C_STATUS_ERROR,
+    I2C_STATUS_TIMEOUT,
+    I2C_STATUS_BUSY,
+    I2C_STATUS_ISOLATED, /**< Device failed repeatedly and is kept off the bus for a while */
+} i2c_status_t;
+
+/**
+ * @brief Transaction priority, the bus is granted to the most urgent queued requester,
+ *        requesters of equal priority are served in order of arrival
+ */
+typedef enum {
+    I2C_PRIORITY_LOW,       /**< Background work like bus scans */
+    I2C_PRIORITY_NORMAL,    /**< Periodic sensor sampling */
+    I2C_PRIORITY_HIGH,      /**< Latency sensitive input, touch reads */
+} i2c_priority_t;
+
+typedef enum {
+    I2C_OP_TRANSMIT,
+    I2C_OP_RECEIVE,
+    I2C_OP_MEM_WRITE,
+    I2C_OP_MEM_READ,
+} i2c_op_t;
+
+typedef struct {
+    i2c_bus_id_t bus;
+    i2c_priority_t priority;
+    i2c_op_t op;
+    uint8_t addr;        /**< 7-bit device address */
+    uint8_t reg;         /**< Register address, memory operations only */
+    uint8_t* data;
+    uint16_t len;
+    uint32_t timeout_ms;
+} i2c_transaction_t;
+
+/**
+ * @brief Utilisation counters of one bus
+ */
+typedef struct {
+    uint32_t transactions;
+    uint32_t failures;
+    uint32_t bytes;          /**< Payload of successful transfers */
+    uint64_t busy_us;        /**< Time the bus was granted to a requester */
+    uint32_t grants;         /**< Bus grants to transfers and probes */
+    uint64_t wait_us;        /**< Time requesters spent queued for the bus, over all grants */
+    uint32_t wait_max_us;
+    uint32_t overtakes;      /**< Grants that went ahead of an earlier queued requester */
+    uint8_t queue_depth;     /**< Requesters queued right now */
+    uint8_t queue_max;
+} i2c_bus_stats_t;
+
+typedef struct {
+    /** Starts transfer, result shall be reported via i2c_bus_complete_handler() */
+    bool (*start)(const i2c_transaction_t* transaction);
+    /** Brings bus back to idle after a transfer that never completed */
+    void (*abort)(i2c_bus_id_t bus);
+    /** Checks if device acknowledges its address */
+    bool (*probe)(i2c_bus_id_t bus, uint8_t addr, uint32_t trials);
+    /** Tells whether SDA and SCL are high, that is no device holds the bus */
+    bool (*lines_released)(i2c_bus_id_t bus);
+    /** Clocks SCL until SDA is released, issues STOP and re-initializes peripheral */
+    bool (*recover)(i2c_bus_id_t bus);
+} i2c_bus_driver_t;
+
+extern i2c_bus_driver_t i2c_bus;
+
+/**
+ * @brief Fills I2C bus driver structure
+ * @note Implemented by HAL backed driver, simulated bus may provide its own
+ */
+void i2c_bus_init_driver(void);
+
+/**
+ * @brief Creates bus locks and fills the driver, shall be called before any transaction
+ */
+void i2c_bus_init(void);
+
+/**
+ * @brief Queues transaction by its priority, calling task sleeps until it is completed
+ * @note A transfer in progress is never interrupted, a more urgent requester gets the bus next
+ *
+ * @return I2C_STATUS_OK on success, I2C_STATUS_BUSY if the bus was not granted within timeout
+ */
+i2c_status_t i2c_bus_transfer(const i2c_transaction_t* transaction);
+
+i2c_status_t i2c_bus_transmit(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, const uint8_t* data, uint16_t len);
+i2c_status_t i2c_bus_receive(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t* data, uint16_t len);
+i2c_status_t i2c_bus_mem_write(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t reg, const uint8_t* data, uint16_t len);
+i2c_status_t i2c_bus_mem_read(i2c_bus_id_t bus, i2c_priority_t priority, uint8_t addr, uint8_t reg, uint8_t* data, uint16_t len);
+
+/**
+ * @brief Checks if device acknowledges its address, queued with low priority
+ */
+bool i2c_bus_probe(i2c_bus_id_t bus, uint8_t addr, uint32_t trials);
+
+/**
+ * @brief Copies utilisation counters of bus
+ */
+void i2c_bus_get_stats(i2c_bus_id_t bus, i2c_bus_stats_t* stats);
+
+/**
+ * @brief Logs utilisation of every bus since the previous report and its queueing counters
+ */
+void i2c_bus_report(void);
+
+/**
+ * @brief Returns status of the last transfer the calling task made on bus, lets callers classify failures
+ *
+ * @return status, I2C_STATUS_OK if the task made no transfers yet
+ */
+i2c_status_t i2c_bus_last_status(i2c_bus_id_t bus);
+
+/**
+ * @brief Called from interrupt context when transfer is finished
+ *
+ * @param success false on bus error or NACK
+ */
+void i2c_bus_complete_handler(i2c_bus_id_t bus, bool success);
@@ -0,0 +1,73 @@
+/**
+ * @file i2c_sim.h
+ * @brief Simulated I2C bus driver, devices are register-level models running in virtual time
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulation replaces HAL driver on host builds, on target it is chosen with I2C_BUS_SIM */
+#if !defined(USE_HAL_DRIVER) || defined(I2C_BUS_SIM)
+#define I2C_SIM_ENABLED 1
+#else
+#define I2C_SIM_ENABLED 0
+#endif
+
+#define I2C_SIM_MAX_DEVICES 8
+#define I2C_SIM_MAX_WRITE   32
+
+#ifndef I2C_SIM_TIME_SCALE
+#define I2C_SIM_TIME_SCALE 1   /**< Virtual milliseconds per real millisecond */
+#endif
+
+/**
+ * @brief Injected faults, every Nth transaction of device is affected, 0 disables the fault
+ */
+typedef struct {
+    uint16_t nack_every;      /**< Device does not acknowledge its address */
+    uint16_t corrupt_every;   /**< Last byte of read data is flipped, breaks CRC */
+    uint16_t stall_every;     /**< Transfer never completes, requester times out */
+    uint16_t not_ready_every; /**< Model specific, conversion takes twice as long */
+    uint16_t hold_sda_every;  /**< Device keeps SDA low until bus recovery, every transfer on the bus fails */
+} i2c_sim_faults_t;
+
+typedef struct i2c_sim_device i2c_sim_device_t;
+
+/**
+ * @brief Simulated device, memory transfers are a register pointer write followed by data
+ */
+struct i2c_sim_device {
+    i2c_bus_id_t bus;
+    uint8_t addr;
+    void (*write)(i2c_sim_device_t* device, const uint8_t* data, uint16_t len);
+    void (*read)(i2c_sim_device_t* device, uint8_t* data, uint16_t len);
+    void* context;
+    bool attached;            /**< Detached device does not respond, used to emulate hot-plug */
+    i2c_sim_faults_t faults;
+    uint32_t transactions;
+};
+
+/**
+ * @brief Adds device to simulated bus, device shall stay valid while simulation runs
+ */
+void i2c_sim_add_device(i2c_sim_device_t* device);
+
+/**
+ * @brief Changes speed of virtual time against real time
+ */
+void i2c_sim_set_time_scale(uint32_t scale);
+
+/**
+ * @brief Returns virtual time in milliseconds
+ */
+uint64_t i2c_sim_time_ms(void);
+
+/**
+ * @brief Tells whether fault with given period hits current transaction of device
+ */
+bool i2c_sim_fault_hits(const i2c_sim_device_t* device, uint16_t every);
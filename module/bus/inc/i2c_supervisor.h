@@ -0,0 +1,39 @@
+/**
+ * @file i2c_supervisor.h
+ * @brief Bus supervisor, recovers stuck lines and isolates repeatedly failing devices
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "i2c_bus.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define I2C_SUPERVISOR_MAX_DEVICES   8   /**< Tracked devices per bus */
+#define I2C_SUPERVISOR_FAILURE_LIMIT 3   /**< Consecutive failures before isolation */
+#define I2C_SUPERVISOR_BACKOFF_MIN_MS 1000
+#define I2C_SUPERVISOR_BACKOFF_MAX_MS 60000
+
+/**
+ * @brief Creates locks of device tables, called by i2c_bus_init
+ */
+void i2c_supervisor_init(void);
+
+/**
+ * @brief Tells whether transfers to device are allowed, isolated devices get a trial
+ *        transfer once their backoff expires
+ */
+bool i2c_supervisor_admit(i2c_bus_id_t bus, uint8_t addr);
+
+/**
+ * @brief Accounts transfer result, recovers bus lines after a failure
+ * @note Shall be called with the bus locked
+ */
+void i2c_supervisor_account(i2c_bus_id_t bus, uint8_t addr, i2c_status_t status);
+
+/**
+ * @brief Logs recovery counters and isolated devices of every bus
+ */
+void i2c_supervisor_report(void);
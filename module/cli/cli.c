@@ -6,17 +6,52 @@
  */
 
 #include "slog.h"
+#include "wear.h"
+#include "sensors.h"
+#include "sample_bus.h"
+#include "i2c_supervisor.h"
+#include "filter.h"
+#include "archivist.h"
 #include "main.h"
 #include "cmsis_os.h"
 
+#define CLI_FLAG_WEAR_REPORT     0x0001
+#define CLI_FLAG_SCHEDULE_REPORT 0x0002
+#define CLI_FLAG_FILTER_BENCHMARK 0x0004
+#define CLI_FLAG_HEALTH_REPORT   0x0008
+#define CLI_FLAGS_ALL            (CLI_FLAG_WEAR_REPORT | CLI_FLAG_SCHEDULE_REPORT | CLI_FLAG_HEALTH_REPORT \
+                                  | CLI_FLAG_FILTER_BENCHMARK)
+
+#define CLI_BURST_WINDOW_MS      10000
+
 static uint8_t rx_buffer[1] = { 0 };
+static osThreadId_t cli_thread;
 
 
 void cli_task(void* argument) {
+    cli_thread = osThreadGetId();
     HAL_UART_Receive_IT(&slog_uart, rx_buffer, 1);
     SLOG_DEBUG("cli_task started");
     for (;;) {
-        osDelay(10000);
+        uint32_t flags = osThreadFlagsWait(CLI_FLAGS_ALL, osFlagsWaitAny, osWaitForever);
+        if (flags & osFlagsError) {
+            continue;
+        }
+        if (flags & CLI_FLAG_WEAR_REPORT) {
+            wear_report();
+        }
+        if (flags & CLI_FLAG_SCHEDULE_REPORT) {
+            sensor_schedule_report();
+            sample_bus_report();
+            i2c_bus_report();
+        }
+        if (flags & CLI_FLAG_HEALTH_REPORT) {
+            sensor_health_report();
+            i2c_supervisor_report();
+        }
+        if (flags & CLI_FLAG_FILTER_BENCHMARK) {
+            filter_benchmark_report();
+        }
     }
 }
 
@@ -33,6 +68,24 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
         case '3':
             HAL_GPIO_TogglePin(LD3_GPIO_Port, LD3_Pin);
             break;
+        case 'w':
+            osThreadFlagsSet(cli_thread, CLI_FLAG_WEAR_REPORT);
+            break;
+        case 's':
+            osThreadFlagsSet(cli_thread, CLI_FLAG_SCHEDULE_REPORT);
+            break;
+        case 'h':
+            osThreadFlagsSet(cli_thread, CLI_FLAG_HEALTH_REPORT);
+            break;
+        case 'b':
+            sensor_burst_start(CLI_BURST_WINDOW_MS);
+            break;
+        case 'f':
+            osThreadFlagsSet(cli_thread, CLI_FLAG_FILTER_BENCHMARK);
+            break;
+        case 'r':
+            archivist_burst_report();
+            break;
         }
     }
 }
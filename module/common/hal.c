@@ -9,9 +9,11 @@
 #include "screen.h"
 #include "memory.h"
 #include "slog.h"
+#include "i2c_bus.h"
 #include "main.h"
 #include "gpio.h"
 #include "spi.h"
+#include "i2c.h"
 #include "usart.h"
 
 /**
@@ -58,3 +60,57 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
         slot_tx_complete_handler();
     }
 }
+
+static void i2c_transfer_complete(I2C_HandleTypeDef* hi2c, bool success) {
+    if (hi2c == &sens_i2c) {
+        i2c_bus_complete_handler(I2C_BUS_SENSORS, success);
+    }
+    if (hi2c == &touch_i2c) {
+        i2c_bus_complete_handler(I2C_BUS_TOUCH, success);
+    }
+}
+
+/**
+ * @brief I2C master transmit complete handler
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    i2c_transfer_complete(hi2c, true);
+}
+
+/**
+ * @brief I2C master receive complete handler
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    i2c_transfer_complete(hi2c, true);
+}
+
+/**
+ * @brief I2C memory write complete handler
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    i2c_transfer_complete(hi2c, true);
+}
+
+/**
+ * @brief I2C memory read complete handler
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    i2c_transfer_complete(hi2c, true);
+}
+
+/**
+ * @brief I2C error handler, NACK included
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+    i2c_transfer_complete(hi2c, false);
+}
@@ -5,45 +5,223 @@
  * @author Andrii Horbul (andreyhorbggwp@gmail.com)
  */
 
+#include "archivist.h"
 #include "sensors.h"
+#include "fusion.h"
+#include "filter.h"
+#include "sample_bus.h"
+#include "replay.h"
+#include "loadgen.h"
+#include "latest.h"
 #include "memory.h"
+#include "memory_layout.h"
+#include "tslog.h"
+#include "rollup.h"
+#include "wear.h"
+#include "burst_log.h"
 #include "gui.h"
 #include "slog.h"
 #include "rtc.h"
 #include "datetime.h"
+#include "monotime.h"
 #include "cmsis_os2.h"
 #include <stdbool.h>
 
-#define SENSOR_READ_VALUE_PERIOD_S 30
+#define CURRENT_VALUE_PERIOD_S     30
 #define CHART_PUSH_VALUE_PERIOD_S  300
 #define MEMORY_SAVE_VALUE_PERIOD_S 600
+#define ROLLUP_STEP_PERIOD_S       1
+
+#define ROLLUP_MIN_AGE_S   (24 * 3600)
+#define ROLLUP_BUCKET_S    (3 * 3600)
+#define ROLLUP_STEP_ENTRIES 16
 
 #define MEMORY_SECTORS_PER_SENSOR 4
+#define MEMORY_LOG_SECTORS_PER_SENSOR 2
+#define MEMORY_ROLLUP_SECTORS_PER_SENSOR (MEMORY_SECTORS_PER_SENSOR - MEMORY_LOG_SECTORS_PER_SENSOR)
+#define MEMORY_LAYOUT_SECTOR (SENSOR_TYPE_COUNT * MEMORY_SECTORS_PER_SENSOR)
+#define MEMORY_WEAR_SECTOR (MEMORY_LAYOUT_SECTOR + 1)
+#define MEMORY_WEAR_SECTORS WEAR_PERSIST_SECTORS
+#define MEMORY_BURST_SECTOR (MEMORY_WEAR_SECTOR + MEMORY_WEAR_SECTORS)
+#define MEMORY_BURST_SECTORS 4
+#define BURST_REPORT_RECORDS 16
+#define MEMORY_SECTOR_COUNT (MEMORY_BURST_SECTOR + MEMORY_BURST_SECTORS)
+/* Version of sector placement and entry formats above, flash of another version is erased at boot */
+#define MEMORY_LAYOUT_VERSION 2
+#define MEMORY_LANE_NONE INT16_MIN
+
+/**
+ * @brief Currently displayed history window, bounded by flash positions
+ */
+typedef struct {
+    tslog_cursor_t cursor;
+    tslog_pos_t start;
+    tslog_pos_t end;
+} history_window_t;
 
-static volatile bool need_sensor_read = true;
+static volatile bool need_current_update = false;
 static volatile bool need_chart_push = true;
 static volatile bool need_memory_save = false;
+static volatile bool need_rollup_step = false;
+static volatile bool need_burst_report = false;
 
-static int32_t last_data[SENSOR_TYPE_COUNT] = {0};
-static int32_t chart_push_data[SENSOR_TYPE_COUNT] = {0};
-static int32_t memory_save_data[SENSOR_TYPE_COUNT] = {0};
-static uint32_t memory_save_addr[SENSOR_TYPE_COUNT] = {0};
+/**
+ * @brief Periodic job driven by sample time, replay runs recorded timeline faster than the timers would
+ */
+typedef struct {
+    volatile bool* need;
+    uint32_t period_s;
+    uint64_t due_us;
+} stream_job_t;
+
+/**
+ * @brief Synthetic load channel, filtered and stored apart from other channels of its type and source
+ */
+typedef struct {
+    filter_state_t filter;
+    sensor_data_type_t type;
+    int8_t lane;
+    int32_t value;              /**< Filtered value not stored yet, FUSION_NO_VALUE for none */
+    uint64_t sample_time_us;    /**< Acquisition time of the newest reading in value */
+} channel_state_t;
+
+static stream_job_t stream_jobs[] = {
+    {&need_current_update, CURRENT_VALUE_PERIOD_S},
+    {&need_chart_push, CHART_PUSH_VALUE_PERIOD_S},
+    {&need_memory_save, MEMORY_SAVE_VALUE_PERIOD_S},
+    {&need_rollup_step, ROLLUP_STEP_PERIOD_S},
+};
+static uint64_t stream_time_us = 0;
+static archivist_stats_t stats;
+
+/* Per-source data indexed by source lane of the quantity, FUSION_NO_VALUE stands for no data */
+static filter_state_t filter_states[SENSOR_TYPE_COUNT][FUSION_MAX_SOURCES];
+static int32_t chart_push_data[SENSOR_TYPE_COUNT][FUSION_MAX_SOURCES];
+static int32_t memory_save_data[SENSOR_TYPE_COUNT][FUSION_MAX_SOURCES];
+/* Acquisition time of the newest reading in memory_save_data, and of the one stored last */
+static uint64_t memory_sample_time_us[SENSOR_TYPE_COUNT];
+static uint64_t memory_saved_time_us[SENSOR_TYPE_COUNT];
+static tslog_t sensor_logs[SENSOR_TYPE_COUNT];
+static tslog_t rollup_logs[SENSOR_TYPE_COUNT];
+static rollup_job_t rollup_jobs[SENSOR_TYPE_COUNT];
+static history_window_t history_windows[SENSOR_TYPE_COUNT];
+static channel_state_t channel_states[LOADGEN_MAX_CHANNELS];
 extern memory_driver_t memory;
 
-static void reading_handler(sensor_data_type_t type, int32_t value) {
-    last_data[type] = value;
+/**
+ * @brief Filters reading of synthetic channel with its own state, the chart shows the latest channel of the lane
+ */
+static void channel_handler(const sensor_sample_t* sample, int8_t lane) {
+    channel_state_t* channel = &channel_states[sample->channel - 1];
+    channel->type = sample->type;
+    channel->lane = lane;
+    channel->value = filter_apply(&channel->filter, filter_get_config(sample->type), sample->value);
+    if (sample->timestamp_us > channel->sample_time_us) {
+        channel->sample_time_us = sample->timestamp_us;
+    }
+    chart_push_data[sample->type][lane] = channel->value;
+}
+
+static void reading_handler(const sensor_sample_t* sample) {
+    int8_t lane = fusion_source_lane(sample->type, sample->source);
+    if (lane < 0 || sample->channel > LOADGEN_MAX_CHANNELS) {
+        stats.unrouted++;
+        return;
+    }
+    stats.filtered++;
+    if (sample->channel > 0) {
+        channel_handler(sample, lane);
+        return;
+    }
+    int32_t value = filter_apply(&filter_states[sample->type][lane], filter_get_config(sample->type), sample->value);
+    chart_push_data[sample->type][lane] = value;
+    memory_save_data[sample->type][lane] = value;
+    if (sample->timestamp_us > memory_sample_time_us[sample->type]) {
+        memory_sample_time_us[sample->type] = sample->timestamp_us;
+    }
+}
+
+static void reset_data(int32_t data[FUSION_MAX_SOURCES]) {
+    for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+        data[lane] = FUSION_NO_VALUE;
+    }
+}
+
+static int32_t chart_value(int32_t value) {
+    return (value != FUSION_NO_VALUE) ? value : LV_CHART_POINT_NONE;
+}
+
+/**
+ * @brief Returns current time of the sample stream, replayed samples run ahead of monotonic clock
+ */
+static uint64_t stream_now_us(void) {
+    return replay_is_active() ? stream_time_us : monotime_now_us();
+}
+
+/**
+ * @brief Advances sample time, raises every job whose period boundary is crossed
+ */
+static void stream_advance(uint64_t time_us) {
+    if (time_us <= stream_time_us) {
+        return;
+    }
+    bool first = stream_time_us == 0;
+    stream_time_us = time_us;
+    for (uint8_t i = 0; i < sizeof(stream_jobs) / sizeof(stream_jobs[0]); i++) {
+        stream_job_t* job = &stream_jobs[i];
+        uint64_t period_us = (uint64_t)job->period_s * 1000000;
+        if (first) {
+            job->due_us = time_us + period_us;
+        } else if (time_us >= job->due_us) {
+            *job->need = true;
+            job->due_us += ((time_us - job->due_us) / period_us + 1) * period_us;
+        }
+    }
+}
+
+/**
+ * @brief Collects per-source values sampled within the last current value period
+ */
+static void latest_data(sensor_data_type_t type, int32_t data[FUSION_MAX_SOURCES]) {
+    const fusion_config_t* config = fusion_get_config(type);
+    const uint64_t now_us = stream_now_us();
+    for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+        latest_value_t latest;
+        data[lane] = FUSION_NO_VALUE;
+        if (lane < config->source_count && latest_read(type, config->sources[lane], &latest)
+            && latest.quality == SAMPLE_QUALITY_GOOD && now_us - latest.timestamp_us <= CURRENT_VALUE_PERIOD_S * 1000000ULL) {
+            data[lane] = latest.value;
+        }
+    }
+}
+
+static bool is_multi_source(sensor_data_type_t type) {
+    return fusion_get_config(type)->source_count > 1;
+}
 
-    if (chart_push_data[type] == 0) {
-        chart_push_data[type] = value;
-    } else {
-        chart_push_data[type] = value + (chart_push_data[type] - value) / 2;
+static int16_t pack_lane(int32_t value) {
+    if (value == FUSION_NO_VALUE) {
+        return MEMORY_LANE_NONE;
+    }
+    if (value > INT16_MAX) {
+        return INT16_MAX;
     }
+    return (value <= MEMORY_LANE_NONE) ? MEMORY_LANE_NONE + 1 : (int16_t)value;
+}
 
-    memory_save_data[type] = chart_push_data[type];
+/**
+ * @brief Decodes entry of multi-source quantity, sources share one timestamp in flash
+ */
+static int32_t packed_entry_value(const memory_entry_t* entry, uint8_t type) {
+    int32_t data[FUSION_MAX_SOURCES];
+    for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+        data[lane] = (entry->lanes[lane] != MEMORY_LANE_NONE) ? entry->lanes[lane] : FUSION_NO_VALUE;
+    }
+    return fusion_apply(type, data);
 }
 
-static void sensor_read_periodic_cb(void* argument) {
-    need_sensor_read = true;
+static void current_update_periodic_cb(void* argument) {
+    need_current_update = true;
 }
 
 static void chart_push_periodic_cb(void* argument) {
@@ -54,186 +232,317 @@ static void memory_save_periodic_cb(void* argument) {
     need_memory_save = true;
 }
 
-static void memory_scan(void) {
-    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-        const uint32_t start_addr = type * memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
-        const uint32_t end_addr = start_addr + memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
-        for (uint32_t addr = start_addr; addr < end_addr; addr += sizeof(memory_entry_t)) {
-            memory_entry_t entry = {0};
-            memory.read(entry.raw, addr, sizeof(entry));
-            if (entry.value == 0xFFFFFFFF) {
-                memory_save_addr[type] = addr;
-                SLOG_DEBUG("sensor type %u, addr to write 0x%06X", type, addr);
-                break;
-            }
-        }
-    }
+static void rollup_step_periodic_cb(void* argument) {
+    need_rollup_step = true;
 }
 
-static void memory_save(void) {
+/**
+ * @brief Reads RTC time and re-anchors monotonic clock to it, so that sample times follow RTC
+ */
+static uint32_t rtc_timestamp_now(void) {
     RTC_DateTypeDef date;
     RTC_TimeTypeDef time;
     HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BCD);
     HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BCD);
-    uint32_t timestamp = datetime_to_timestamp(2000 + date.Year, date.Month, date.Date, time.Hours, time.Minutes, 0);
-    SLOG_DEBUG("sensor data save with timestamp %lu", timestamp);
+    uint32_t timestamp = datetime_to_timestamp(2000 + date.Year, date.Month, date.Date, time.Hours, time.Minutes, time.Seconds);
+    /* Sub-second register counts down from SecondFraction within every second */
+    uint32_t fraction_us = (uint32_t)((uint64_t)(time.SecondFraction - time.SubSeconds) * 1000000 / (time.SecondFraction + 1));
+    monotime_anchor(timestamp, fraction_us);
+    return timestamp;
+}
 
+/**
+ * @brief Restores write positions and zone maps of stored logs
+ */
+static void memory_scan(void) {
     for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-        const uint32_t start_addr = type * memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
-        if (memory_save_addr[type] % memory.sector_size == 0) {
-            memory.erase_sector(memory_save_addr[type]);
-        }
-
-        memory_entry_t entry;
-        entry.timestamp = timestamp;
-        entry.value = memory_save_data[type];
-        memory.write(entry.raw, memory_save_addr[type], sizeof(entry));
-        SLOG_DEBUG("sensor type %u value saved at 0x%06X", type, memory_save_addr[type]);
-        memory_save_addr[type] += sizeof(memory_entry_t);
-        memory_save_addr[type] = start_addr + (memory_save_addr[type] - start_addr) % (memory.sector_size * 2);
+        tslog_scan(&sensor_logs[type]);
+        tslog_scan(&rollup_logs[type]);
     }
 }
 
-static void memory_load_data_from_timestamp(sensor_data_type_t type, uint32_t timestamp, int32_t* values, uint16_t count) {
-    for (uint16_t i = 0; i < count; i++) {
-        values[i] = LV_CHART_POINT_NONE;
-    }
-
-    if (type >= SENSOR_TYPE_COUNT || count == 0) {
-        SLOG_WARN("Invalid arguments to memory_load_data: type=%d, count=%u", type, count);
-        return;
-    }
+/**
+ * @brief Converts sample acquisition time to RTC timestamp, RTC time is used while clock is not anchored
+ */
+static uint32_t sample_timestamp(uint64_t time_us, uint32_t fallback) {
+    uint32_t timestamp = monotime_to_timestamp(time_us);
+    return (timestamp != 0) ? timestamp : fallback;
+}
 
-    const uint32_t sensor_region_size_bytes = memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
+static void memory_append(sensor_data_type_t type, const memory_entry_t* entry) {
+    rollup_job_before_append(&rollup_jobs[type], entry->timestamp);
+    tslog_append(&sensor_logs[type], entry);
+    wear_account_payload(sizeof(*entry));
+    stats.stored++;
+}
 
-    if (sensor_region_size_bytes == 0 || sizeof(memory_entry_t) == 0) {
-        SLOG_ERROR("Memory region size (0x%lX) or entry size (%u) is zero for type: %d",
-            sensor_region_size_bytes, (unsigned int)sizeof(memory_entry_t), type);
-        return;
+/**
+ * @brief Stores one entry per synthetic channel filtered since the previous save into the log of its type,
+ *        entries of a type share acquisition time of the newest reading among them to keep the log in time order
+ */
+static void memory_save_channels(uint32_t now) {
+    uint64_t newest_us[SENSOR_TYPE_COUNT] = {0};
+    for (uint16_t c = 0; c < LOADGEN_MAX_CHANNELS; c++) {
+        const channel_state_t* channel = &channel_states[c];
+        if (channel->value != FUSION_NO_VALUE && channel->sample_time_us > newest_us[channel->type]) {
+            newest_us[channel->type] = channel->sample_time_us;
+        }
     }
-
-    const uint32_t total_slots_per_sensor = sensor_region_size_bytes / sizeof(memory_entry_t);
-    if (total_slots_per_sensor == 0) {
-        SLOG_WARN("No slots available in memory for type %d. Region: %luB, Entry: %uB",
-            type, sensor_region_size_bytes, (unsigned int)sizeof(memory_entry_t));
-        return;
+    for (uint16_t c = 0; c < LOADGEN_MAX_CHANNELS; c++) {
+        channel_state_t* channel = &channel_states[c];
+        if (channel->value == FUSION_NO_VALUE) {
+            continue;
+        }
+        memory_entry_t entry;
+        entry.timestamp = sample_timestamp(newest_us[channel->type], now);
+        if (is_multi_source(channel->type)) {
+            for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+                entry.lanes[lane] = (lane == channel->lane) ? pack_lane(channel->value) : MEMORY_LANE_NONE;
+            }
+        } else {
+            entry.value = channel->value;
+        }
+        memory_append(channel->type, &entry);
+        channel->value = FUSION_NO_VALUE;
     }
+}
 
-    const uint32_t sensor_start_addr = (uint32_t)type * sensor_region_size_bytes;
-    const uint32_t sensor_end_addr = sensor_start_addr + sensor_region_size_bytes;
-
-    uint32_t current_next_write_addr = memory_save_addr[type];
-
-    uint32_t addr_of_newest_entry;
-    bool buffer_is_effectively_empty = false;
+/**
+ * @brief Stores per-type values stamped with acquisition time of their newest reading,
+ *        types without readings since the previous save are skipped
+ */
+static void memory_save(void) {
+    uint32_t now = rtc_timestamp_now();
+    SLOG_DEBUG("sensor data save at timestamp %lu", now);
 
-    if (current_next_write_addr == sensor_start_addr) {
-        addr_of_newest_entry = sensor_end_addr - sizeof(memory_entry_t);
-        memory_entry_t entry_in_last_slot;
-        memory.read(entry_in_last_slot.raw, addr_of_newest_entry, sizeof(entry_in_last_slot));
-        if (entry_in_last_slot.timestamp == 0xFFFFFFFF || entry_in_last_slot.value == 0xFFFFFFFF) {
-            buffer_is_effectively_empty = true;
+    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        if (fusion_apply(type, memory_save_data[type]) == FUSION_NO_VALUE
+            || memory_sample_time_us[type] == memory_saved_time_us[type]) {
+            continue;
         }
-    } else {
-        addr_of_newest_entry = current_next_write_addr - sizeof(memory_entry_t);
-        memory_entry_t entry_before_next_write;
-        memory.read(entry_before_next_write.raw, addr_of_newest_entry, sizeof(entry_before_next_write));
-        if (entry_before_next_write.timestamp == 0xFFFFFFFF || entry_before_next_write.value == 0xFFFFFFFF) {
-            buffer_is_effectively_empty = true;
+        memory_saved_time_us[type] = memory_sample_time_us[type];
+        uint32_t timestamp = sample_timestamp(memory_sample_time_us[type], now);
+        memory_entry_t entry;
+        entry.timestamp = timestamp;
+        if (is_multi_source(type)) {
+            for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+                entry.lanes[lane] = pack_lane(memory_save_data[type][lane]);
+            }
+        } else {
+            entry.value = memory_save_data[type][0];
         }
+        memory_append(type, &entry);
     }
+    memory_save_channels(now);
+}
 
-    if (buffer_is_effectively_empty) {
-        SLOG_DEBUG("Memory effectively empty for type %d. Target ts: %lu", type, timestamp);
-        return;
+static int16_t window_delta(int32_t extreme, int32_t mean) {
+    int32_t delta = extreme - mean;
+    if (delta > INT16_MAX) {
+        return INT16_MAX;
     }
+    return (delta < INT16_MIN) ? INT16_MIN : (int16_t)delta;
+}
 
-    memory_entry_t newest_entry_data;
-    memory.read(newest_entry_data.raw, addr_of_newest_entry, sizeof(newest_entry_data));
+/**
+ * @brief Stores decimated burst window as one record instead of every reading
+ */
+static void burst_save(const sensor_sample_t* sample) {
+    burst_record_t record = {
+        .timestamp = sample_timestamp(sample->timestamp_us, rtc_timestamp_now()),
+        .type = sample->type,
+        .source = sample->source,
+        .count = sample->count,
+        .mean = sample->value,
+        .min_delta = window_delta(sample->min, sample->value),
+        .max_delta = window_delta(sample->max, sample->value),
+    };
+    burst_log_append(&record);
+    wear_account_payload(sizeof(record));
+    stats.burst++;
+    SLOG_DEBUG("burst %s type %d: mean %ld min %ld max %ld of %u readings", fusion_source_name(sample->source),
+        sample->type, sample->value, sample->min, sample->max, sample->count);
+}
 
-    if (newest_entry_data.timestamp == 0xFFFFFFFF || newest_entry_data.value == 0xFFFFFFFF) {
-        SLOG_WARN("Newest entry at 0x%06lX (type %d) is unwritten. Target ts: %lu", 
-            addr_of_newest_entry, type, timestamp);
-        return;
+/**
+ * @brief Compacts a small portion of old raw entries per sensor type,
+ *        so that it never noticeably delays sampling and gui processing
+ */
+static void rollup_step(void) {
+    uint32_t now = rtc_timestamp_now();
+    if (replay_is_active()) {
+        now = sample_timestamp(stream_time_us, now);
     }
-
-    if (timestamp > newest_entry_data.timestamp) {
-        SLOG_DEBUG("Timestamp %lu too new for type %d (newest entry ts: %lu).",
-            timestamp, type, newest_entry_data.timestamp);
-        return;
+    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        rollup_job_step(&rollup_jobs[type], now, ROLLUP_STEP_ENTRIES);
     }
+}
 
-    uint32_t search_iter_addr = addr_of_newest_entry;
-    uint32_t data_read_start_addr = 0;
-
-    for (uint32_t i = 0; i < total_slots_per_sensor; ++i) {
-        memory_entry_t current_search_entry;
-        memory.read(current_search_entry.raw, search_iter_addr, sizeof(current_search_entry));
-
-        if (current_search_entry.timestamp == 0xFFFFFFFF || current_search_entry.value == 0xFFFFFFFF) {
-            break;
-        }
-
-        if (current_search_entry.timestamp <= timestamp) {
-            data_read_start_addr = search_iter_addr;
-            break;
-        }
+/**
+ * @brief Fills values left unread by cursor with empty chart points
+ */
+static uint16_t history_window_finish(int32_t* values, uint16_t loaded, uint16_t count) {
+    for (uint16_t i = loaded; i < count; i++) {
+        values[i] = LV_CHART_POINT_NONE;
+    }
+    return loaded;
+}
 
-        if (search_iter_addr == sensor_start_addr) {
-            search_iter_addr = sensor_end_addr - sizeof(memory_entry_t);
-        } else {
-            search_iter_addr -= sizeof(memory_entry_t);
+/**
+ * @brief Loads history window starting from the newest entry not later than timestamp
+ */
+static uint16_t history_seek(sensor_data_type_t type, uint32_t timestamp, int32_t* values, uint16_t count) {
+    if (type >= SENSOR_TYPE_COUNT || count == 0) {
+        SLOG_WARN("Invalid arguments to history_seek: type=%d, count=%u", type, count);
+        return 0;
+    }
+    history_window_t* window = &history_windows[type];
+    tslog_cursor_init(&window->cursor, &sensor_logs[type]);
+    if (!tslog_cursor_seek(&window->cursor, timestamp)) {
+        /* Raw samples already reclaimed, fall back to coarse rollups */
+        tslog_cursor_init(&window->cursor, &rollup_logs[type]);
+        if (!tslog_cursor_seek(&window->cursor, timestamp)) {
+            window->start = window->end = tslog_cursor_tell(&window->cursor);
+            return history_window_finish(values, 0, count);
         }
+    }
+    window->start = tslog_cursor_tell(&window->cursor);
+    uint16_t loaded = tslog_cursor_next(&window->cursor, values, NULL, count);
+    window->end = tslog_cursor_tell(&window->cursor);
+    SLOG_DEBUG("type %d: history window from ts %lu, %u of %u values loaded", type, timestamp, loaded, count);
+    return history_window_finish(values, loaded, count);
+}
 
-        if (i > 0 && search_iter_addr == addr_of_newest_entry) {
-            break;
-        }
+/**
+ * @brief Loads history window following the current one, current one is kept if nothing newer is stored
+ */
+static uint16_t history_next(sensor_data_type_t type, int32_t* values, uint16_t count) {
+    if (type >= SENSOR_TYPE_COUNT || count == 0) {
+        return 0;
     }
+    history_window_t* window = &history_windows[type];
+    tslog_cursor_restore(&window->cursor, window->end);
+    uint16_t loaded = tslog_cursor_next(&window->cursor, values, NULL, count);
+    if (loaded == 0) {
+        return 0;
+    }
+    window->start = window->end;
+    window->end = tslog_cursor_tell(&window->cursor);
+    return history_window_finish(values, loaded, count);
+}
 
-    if (data_read_start_addr == 0) {
-        SLOG_DEBUG("Timestamp %lu too old for type %d (no entry with ts <= target found). Newest ts was: %lu",
-            timestamp, type, newest_entry_data.timestamp);
-        return;
+/**
+ * @brief Loads history window preceding the current one, current one is kept if nothing older is stored
+ */
+static uint16_t history_prev(sensor_data_type_t type, int32_t* values, uint16_t count) {
+    if (type >= SENSOR_TYPE_COUNT || count == 0) {
+        return 0;
+    }
+    history_window_t* window = &history_windows[type];
+    tslog_cursor_restore(&window->cursor, window->start);
+    uint16_t loaded = tslog_cursor_prev(&window->cursor, values, NULL, count);
+    if (loaded == 0) {
+        return 0;
+    }
+    window->end = window->start;
+    window->start = tslog_cursor_tell(&window->cursor);
+
+    /* Cursor reads backwards, restore chronological order in place */
+    for (uint16_t i = 0; i < loaded / 2; i++) {
+        int32_t tmp = values[i];
+        values[i] = values[loaded - 1 - i];
+        values[loaded - 1 - i] = tmp;
     }
+    return history_window_finish(values, loaded, count);
+}
 
-    uint32_t current_read_addr = data_read_start_addr;
-    SLOG_DEBUG("Type %d: Starting forward read from addr 0x%06lX for %u items. Target ts: %lu. Newest ts: %lu",
-        type, current_read_addr, count, timestamp, newest_entry_data.timestamp);
+/**
+ * @brief Finds max value within time range using page zone maps of raw and rollup logs
+ */
+static bool history_peak(sensor_data_type_t type, uint32_t from_ts, uint32_t to_ts, int32_t* value, uint32_t* timestamp) {
+    static tslog_cursor_t query_cursor;
+    if (type >= SENSOR_TYPE_COUNT) {
+        return false;
+    }
 
-    for (uint16_t i = 0; i < count; ++i) {
-        if (current_read_addr == current_next_write_addr && current_next_write_addr != sensor_start_addr) {
-            SLOG_DEBUG("Type %d: Reached next_write_addr 0x%06lX (non-wrapping) at item %u. Stopping read.",
-                type, current_read_addr, i);
-            break;
+    bool found = false;
+    tslog_t* logs[] = {&sensor_logs[type], &rollup_logs[type]};
+    for (uint8_t i = 0; i < sizeof(logs) / sizeof(logs[0]); i++) {
+        memory_entry_t peak;
+        tslog_cursor_init(&query_cursor, logs[i]);
+        if (tslog_find_max(&query_cursor, from_ts, to_ts, &peak) && (!found || peak.value > *value)) {
+            found = true;
+            *value = peak.value;
+            *timestamp = peak.timestamp;
         }
+    }
+    return found;
+}
 
-        memory_entry_t entry_to_load;
-        memory.read(entry_to_load.raw, current_read_addr, sizeof(entry_to_load));
+static const history_data_source_t history_data_source = {
+    .seek = history_seek,
+    .next = history_next,
+    .prev = history_prev,
+    .peak = history_peak,
+};
 
-        if (entry_to_load.timestamp == 0xFFFFFFFF || entry_to_load.value == 0xFFFFFFFF) {
-            SLOG_DEBUG("Type %d: Hit unwritten slot at 0x%06lX (ts:0x%08lX) at item %u. Stopping read.",
-                type, current_read_addr, entry_to_load.timestamp, i);
-            break;
+/**
+ * @brief Runs periodic jobs raised by timers or by sample time
+ */
+static void run_due_jobs(void) {
+    if (need_current_update) {
+        need_current_update = false;
+        for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+            int32_t data[FUSION_MAX_SOURCES];
+            latest_data(type, data);
+            gui_sensmon_update_current_value(type, chart_value(fusion_apply(type, data)));
         }
-
-        values[i] = entry_to_load.value;
-
-        current_read_addr += sizeof(memory_entry_t);
-        if (current_read_addr >= sensor_end_addr) {
-            current_read_addr = sensor_start_addr;
+    }
+    if (need_chart_push) {
+        need_chart_push = false;
+        for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+            gui_sensmon_push_chart_value(type, chart_value(fusion_apply(type, chart_push_data[type])));
+            if (is_multi_source(type)) {
+                for (uint8_t lane = 0; lane < fusion_get_config(type)->source_count; lane++) {
+                    gui_sensmon_push_source_chart_value(type, lane, chart_value(chart_push_data[type][lane]));
+                }
+            }
+            reset_data(chart_push_data[type]);
         }
     }
-    SLOG_DEBUG("Type %d: memory_load_data_from_timestamp completed. %u values processed.", type, count);
+    if (need_memory_save) {
+        need_memory_save = false;
+        memory_save();
+    }
+    if (need_rollup_step) {
+        need_rollup_step = false;
+        rollup_step();
+    }
+    if (need_burst_report) {
+        need_burst_report = false;
+        burst_log_report(BURST_REPORT_RECORDS);
+    }
+}
+
+void archivist_get_stats(archivist_stats_t* copy) {
+    *copy = stats;
+}
+
+void archivist_burst_report(void) {
+    need_burst_report = true;
 }
 
 void archivist_task(void* argument) {
     osDelay(200);
     gui_init();
-    gui_history_init_data_fetcher(memory_load_data_from_timestamp);
+    gui_history_init_data_source(&history_data_source);
 
     memory_init_driver();
     memory.init();
     SLOG_DEBUG("memory id: 0x%06X", memory.get_id());
+    memory_layout_check(MEMORY_LAYOUT_SECTOR * memory.sector_size, MEMORY_LAYOUT_VERSION, MEMORY_SECTOR_COUNT);
+    wear_init(MEMORY_SECTOR_COUNT, MEMORY_WEAR_SECTOR * memory.sector_size);
+    burst_log_init(MEMORY_BURST_SECTOR * memory.sector_size, MEMORY_BURST_SECTORS * memory.sector_size);
 
     while (!gui_is_datetime_configured()) {
         gui_process();
@@ -241,45 +550,68 @@ void archivist_task(void* argument) {
     }
 
     for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-        memory_save_addr[type] = type * memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
+        const uint32_t region_addr = type * memory.sector_size * MEMORY_SECTORS_PER_SENSOR;
+        tslog_init(&sensor_logs[type], region_addr, memory.sector_size * MEMORY_LOG_SECTORS_PER_SENSOR);
+        tslog_init(&rollup_logs[type], region_addr + memory.sector_size * MEMORY_LOG_SECTORS_PER_SENSOR,
+            memory.sector_size * MEMORY_ROLLUP_SECTORS_PER_SENSOR);
+        if (is_multi_source(type)) {
+            tslog_set_decoder(&sensor_logs[type], packed_entry_value, type);
+        }
+    }
+    memory_scan();
+    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        reset_data(chart_push_data[type]);
+        reset_data(memory_save_data[type]);
+        memory_sample_time_us[type] = memory_saved_time_us[type] = 0;
+        for (uint8_t lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+            filter_reset(&filter_states[type][lane]);
+        }
+        tslog_cursor_init(&history_windows[type].cursor, &sensor_logs[type]);
+        rollup_job_init(&rollup_jobs[type], &sensor_logs[type], &rollup_logs[type], ROLLUP_MIN_AGE_S, ROLLUP_BUCKET_S);
+    }
+    for (uint16_t c = 0; c < LOADGEN_MAX_CHANNELS; c++) {
+        filter_reset(&channel_states[c].filter);
+        channel_states[c].value = FUSION_NO_VALUE;
     }
-    //memory_scan();
 
-    osTimerId_t sensor_read_periodic = osTimerNew(sensor_read_periodic_cb, osTimerPeriodic, NULL, NULL);
-    osTimerStart(sensor_read_periodic, SENSOR_READ_VALUE_PERIOD_S * 1000);
-    osTimerId_t chart_push_periodic = osTimerNew(chart_push_periodic_cb, osTimerPeriodic, NULL, NULL);
-    osTimerStart(chart_push_periodic, CHART_PUSH_VALUE_PERIOD_S * 1000);
-    osTimerId_t memory_save_periodic = osTimerNew(memory_save_periodic_cb, osTimerPeriodic, NULL, NULL);
-    osTimerStart(memory_save_periodic, MEMORY_SAVE_VALUE_PERIOD_S * 1000);
+    /* Anchor monotonic clock before the first sample is stamped */
+    rtc_timestamp_now();
+    sample_bus_subscriber_t* samples = sample_bus_subscribe("archivist");
+    if (!replay_init()) {
+        loadgen_init();
+    }
+    sensor_acquisition_start();
+
+    if (!replay_is_active()) {
+        osTimerId_t current_update_periodic = osTimerNew(current_update_periodic_cb, osTimerPeriodic, NULL, NULL);
+        osTimerStart(current_update_periodic, CURRENT_VALUE_PERIOD_S * 1000);
+        osTimerId_t chart_push_periodic = osTimerNew(chart_push_periodic_cb, osTimerPeriodic, NULL, NULL);
+        osTimerStart(chart_push_periodic, CHART_PUSH_VALUE_PERIOD_S * 1000);
+        osTimerId_t memory_save_periodic = osTimerNew(memory_save_periodic_cb, osTimerPeriodic, NULL, NULL);
+        osTimerStart(memory_save_periodic, (loadgen_is_active() ? LOADGEN_SAVE_PERIOD_S : MEMORY_SAVE_VALUE_PERIOD_S) * 1000);
+        osTimerId_t rollup_step_periodic = osTimerNew(rollup_step_periodic_cb, osTimerPeriodic, NULL, NULL);
+        osTimerStart(rollup_step_periodic, ROLLUP_STEP_PERIOD_S * 1000);
+    }
 
     for (;;) {
-        if (need_sensor_read) {
-            need_sensor_read = false;
-            sensor_process_reading(reading_handler);
-            for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-                if (last_data[type] != 0) {
-                    gui_sensmon_update_current_value(type, last_data[type]);
-                    last_data[type] = 0;
-                } else {
-                    gui_sensmon_update_current_value(type, LV_CHART_POINT_NONE);
-                }
+        const sensor_sample_t* peeked;
+        while ((peeked = sample_bus_peek(samples)) != NULL) {
+            sensor_sample_t sample = *peeked;
+            if (!sample_bus_release(samples)) {
+                continue;
             }
-        }
-        if (need_chart_push) {
-            need_chart_push = false;
-            for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-                if (chart_push_data[type] != 0) {
-                    gui_sensmon_push_chart_value(type, chart_push_data[type]);
-                    chart_push_data[type] = 0;
-                } else {
-                    gui_sensmon_push_chart_value(type, LV_CHART_POINT_NONE);
-                }
+            stats.received++;
+            if (replay_is_active()) {
+                /* Jobs due before the sample see only data preceding it */
+                stream_advance(sample.timestamp_us);
+                run_due_jobs();
             }
+            if (sample.count > 1) {
+                burst_save(&sample);
+            }
+            reading_handler(&sample);
         }
-        if (need_memory_save) {
-            need_memory_save = false;
-            memory_save();
-        }
+        run_due_jobs();
         gui_process();
         osDelay(5);
     }
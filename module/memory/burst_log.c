@@ -0,0 +1,94 @@
+/**
+ * @file burst_log.c
+ * @brief Flash ring of burst acquisition windows, one enriched record per window and channel
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "burst_log.h"
+#include "memory.h"
+#include "slog.h"
+#include "fusion.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BURST_LOG_SCAN_RECORDS 16
+
+extern memory_driver_t memory;
+
+static uint32_t log_start_addr;
+static uint32_t log_size;
+static uint32_t log_write_addr;
+
+void burst_log_init(uint32_t start_addr, uint32_t size) {
+    log_start_addr = start_addr;
+    log_size = size;
+    log_write_addr = start_addr;
+
+    /* Records are written in time order, the next one goes after the newest */
+    static burst_record_t chunk[BURST_LOG_SCAN_RECORDS];
+    uint32_t newest_timestamp = 0;
+    bool found = false;
+    for (uint32_t addr = start_addr; addr < start_addr + size; addr += sizeof(chunk)) {
+        memory.read((uint8_t*)chunk, addr, sizeof(chunk));
+        for (uint32_t i = 0; i < BURST_LOG_SCAN_RECORDS; i++) {
+            if (chunk[i].timestamp == 0xFFFFFFFF || (found && chunk[i].timestamp < newest_timestamp)) {
+                continue;
+            }
+            found = true;
+            newest_timestamp = chunk[i].timestamp;
+            log_write_addr = addr + (i + 1) * sizeof(burst_record_t);
+        }
+    }
+    if (log_write_addr >= start_addr + size) {
+        log_write_addr = start_addr;
+    }
+    SLOG_DEBUG("burst log 0x%06X, addr to write 0x%06X", start_addr, log_write_addr);
+}
+
+void burst_log_append(const burst_record_t* record) {
+    if (log_size == 0) {
+        return;
+    }
+    if ((log_write_addr - log_start_addr) % memory.sector_size == 0) {
+        memory.erase_sector(log_write_addr);
+    }
+    memory.write(record->raw, log_write_addr, sizeof(*record));
+    log_write_addr += sizeof(burst_record_t);
+    if (log_write_addr >= log_start_addr + log_size) {
+        log_write_addr = log_start_addr;
+    }
+}
+
+uint16_t burst_log_read(uint16_t skip, burst_record_t* records, uint16_t count) {
+    if (log_size == 0) {
+        return 0;
+    }
+    /* Walks back from the newest record, the erased tail of the sector being written ends the ring */
+    const uint32_t capacity = log_size / sizeof(burst_record_t);
+    uint32_t addr = log_write_addr;
+    uint16_t loaded = 0;
+    for (uint32_t i = 0; i < capacity && loaded < count; i++) {
+        addr = ((addr == log_start_addr) ? log_start_addr + log_size : addr) - sizeof(burst_record_t);
+        burst_record_t record;
+        memory.read(record.raw, addr, sizeof(record));
+        if (record.timestamp == 0xFFFFFFFF) {
+            break;
+        }
+        if (i >= skip) {
+            records[loaded++] = record;
+        }
+    }
+    return loaded;
+}
+
+void burst_log_report(uint16_t count) {
+    burst_record_t record;
+    uint16_t i = 0;
+    for (; i < count && burst_log_read(i, &record, 1) == 1; i++) {
+        const char* source = fusion_source_name(record.source);
+        SLOG_INFO("burst ts %lu %s type %u: mean %ld min %+d max %+d of %u readings", record.timestamp,
+            (source != NULL) ? source : "?", record.type, record.mean, record.min_delta, record.max_delta, record.count);
+    }
+    SLOG_INFO("burst log: %u newest records", i);
+}
@@ -0,0 +1,33 @@
+/**
+ * @file archivist.h
+ * @brief Contains logics for processing (save, display) sensor readings
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Samples passed through each stage of archivist since start
+ */
+typedef struct {
+    uint32_t received;  /**< Taken from sample bus */
+    uint32_t unrouted;  /**< Dropped, no fusion lane for the type and source */
+    uint32_t filtered;  /**< Passed filter into per-lane data, later ones overwrite earlier until saved */
+    uint32_t burst;     /**< Decimated windows written to burst log */
+    uint32_t stored;    /**< Entries appended to sensor logs */
+} archivist_stats_t;
+
+/**
+ * @brief Copies stage counters
+ * @note Counters are updated by archivist task, a copy taken meanwhile may mix stages by one sample
+ */
+void archivist_get_stats(archivist_stats_t* stats);
+
+/**
+ * @brief Requests printing of the newest burst log records
+ * @note Flash is accessed by archivist task only, records are printed there. Safe to call from ISR
+ */
+void archivist_burst_report(void);
@@ -0,0 +1,54 @@
+/**
+ * @file burst_log.h
+ * @brief Flash ring of burst acquisition windows, one enriched record per window and channel
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Decimated burst window, extremes are kept relative to the mean
+ */
+typedef union {
+    struct {
+        uint32_t timestamp;
+        uint8_t type;
+        uint8_t source;
+        uint16_t count;     /**< Readings within the window */
+        int32_t mean;
+        int16_t min_delta;  /**< Saturated min - mean */
+        int16_t max_delta;  /**< Saturated max - mean */
+    };
+    uint8_t raw[16];
+} burst_record_t;
+
+/**
+ * @brief Places log into flash region and finds position after the newest record
+ *
+ * @param start_addr sector aligned region address
+ * @param size region size, multiple of sector size
+ */
+void burst_log_init(uint32_t start_addr, uint32_t size);
+
+/**
+ * @brief Appends record, the oldest sector is erased when ring wraps
+ */
+void burst_log_append(const burst_record_t* record);
+
+/**
+ * @brief Reads records starting from the newest one
+ *
+ * @param skip newest records to pass over
+ * @param records buffer for records, newest first
+ * @param count buffer capacity
+ * @return number of records read, less than count once the oldest record is reached
+ */
+uint16_t burst_log_read(uint16_t skip, burst_record_t* records, uint16_t count);
+
+/**
+ * @brief Prints newest records
+ */
+void burst_log_report(uint16_t count);
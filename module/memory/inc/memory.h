@@ -13,7 +13,10 @@
 typedef union {
     struct {
         uint32_t timestamp;
-        int32_t value;
+        union {
+            int32_t value;
+            int16_t lanes[2]; /**< Values of a multi-source quantity sharing the timestamp */
+        };
     };
     uint8_t raw[8];
 } memory_entry_t;
@@ -32,7 +35,8 @@ extern memory_driver_t memory;
 
 /**
  * @brief Fills memory driver structure
- * @note Shall be implemented in you flash memory IC driver source file
+ * @note Shall be implemented in you flash memory IC driver source file, driver functions
+ *       are called from several tasks and shall serialize access to the chip
  */
 void memory_init_driver(void);
 
@@ -0,0 +1,22 @@
+/**
+ * @file memory_layout.h
+ * @brief Marker of flash layout version, flash written by another layout is erased before use
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Checks layout marker, erases sectors [0, sector_count) and writes the marker if it does not match
+ * @note Shall be called before any module reads its region, marker sector shall be among the erased ones
+ *
+ * @param marker_addr sector aligned address of the marker
+ * @param version layout version, changed whenever placement or format of stored data changes
+ * @param sector_count number of sectors used by the layout starting from address 0
+ * @return true - flash keeps current layout, false - flash was erased
+ */
+bool memory_layout_check(uint32_t marker_addr, uint32_t version, uint16_t sector_count);
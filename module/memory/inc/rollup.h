@@ -0,0 +1,48 @@
+/**
+ * @file rollup.h
+ * @brief Incremental compaction of old raw samples into coarse aggregates
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "tslog.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Compaction job state for one raw log and its rollup log
+ */
+typedef struct {
+    tslog_t* raw;
+    tslog_t* rollup;
+    tslog_cursor_t cursor;  /**< Next raw entry to be compacted */
+    uint32_t min_age_s;     /**< Raw entries younger than this are left alone */
+    uint32_t bucket_s;      /**< Aggregate period */
+    uint32_t bucket_start;
+    int64_t bucket_sum;
+    uint16_t bucket_count;
+} rollup_job_t;
+
+/**
+ * @brief Initializes job and places it at the oldest raw entry not compacted yet
+ * @note Logs shall be scanned before, a bucket left open by the previous run is rebuilt from raw entries still stored
+ *
+ * @param min_age_s age after which raw entries are compacted
+ * @param bucket_s period of one aggregate entry
+ */
+void rollup_job_init(rollup_job_t* job, tslog_t* raw, tslog_t* rollup, uint32_t min_age_s, uint32_t bucket_s);
+
+/**
+ * @brief Compacts at most max_entries raw entries eligible at time now
+ *
+ * @return true - more eligible entries are pending
+ */
+bool rollup_job_step(rollup_job_t* job, uint32_t now, uint16_t max_entries);
+
+/**
+ * @brief Must be called before appending to raw log, compacts entries of the sector
+ *        that the append is going to erase regardless of their age
+ */
+void rollup_job_before_append(rollup_job_t* job, uint32_t now);
@@ -0,0 +1,173 @@
+/**
+ * @file tslog.h
+ * @brief Time-series log stored in flash ring buffer and cursor over it
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TSLOG_PAGE_SIZE 256
+#define TSLOG_PAGE_ENTRIES (TSLOG_PAGE_SIZE / sizeof(memory_entry_t))
+#define TSLOG_MAX_PAGES 32
+
+/**
+ * @brief Summary of one stored page, kept in RAM to skip pages without reading them
+ */
+typedef struct {
+    uint32_t first_ts; /**< 0xFFFFFFFF if page holds no entries */
+    uint32_t last_ts;
+    int32_t min;
+    int32_t max;
+} tslog_zone_t;
+
+/**
+ * @brief Turns stored entry into its logical value, used for logs keeping packed entries
+ *
+ * @param tag value given to tslog_set_decoder()
+ */
+typedef int32_t (*tslog_decode_func_t)(const memory_entry_t* entry, uint8_t tag);
+
+/**
+ * @brief Ring buffer of memory entries occupying whole flash sectors
+ */
+typedef struct {
+    uint32_t start_addr; /**< First byte of the ring, sector aligned */
+    uint32_t size;       /**< Ring size in bytes, multiple of sector size */
+    uint32_t write_addr; /**< Address of the next entry to be written */
+    uint32_t generation; /**< Incremented on every append, invalidates cursor caches */
+    tslog_decode_func_t decode; /**< NULL if entries keep plain value */
+    uint8_t decode_tag;
+    tslog_zone_t zones[TSLOG_MAX_PAGES];
+} tslog_t;
+
+/**
+ * @brief Iterator over tslog entries with its own single page cache
+ */
+typedef struct {
+    tslog_t* log;
+    uint32_t addr;       /**< Address of the entry returned by next() */
+    bool at_oldest;      /**< addr equals write_addr of a wrapped ring and means its oldest entry, not the end */
+    uint32_t cache_addr; /**< Address of cached page, UINT32_MAX if empty */
+    uint32_t cache_generation;
+    memory_entry_t cache[TSLOG_PAGE_ENTRIES];
+} tslog_cursor_t;
+
+/**
+ * @brief Saved cursor position
+ */
+typedef struct {
+    uint32_t addr;
+    bool at_oldest;
+} tslog_pos_t;
+
+/**
+ * @brief Initializes log placed in [start_addr, start_addr + size)
+ */
+void tslog_init(tslog_t* log, uint32_t start_addr, uint32_t size);
+
+/**
+ * @brief Sets decoder of logical entry values, shall be called before tslog_scan()
+ * @note Values returned by cursors, zones and find functions are decoded ones
+ */
+void tslog_set_decoder(tslog_t* log, tslog_decode_func_t decode, uint8_t tag);
+
+/**
+ * @brief Finds first unwritten slot and continues writing from it, rebuilds page zones
+ */
+void tslog_scan(tslog_t* log);
+
+/**
+ * @brief Appends entry, erases next sector when crossing sector boundary
+ */
+void tslog_append(tslog_t* log, const memory_entry_t* entry);
+
+/**
+ * @brief Checks if the next append starts a new sector and erases it
+ */
+bool tslog_append_will_erase(const tslog_t* log);
+
+/**
+ * @brief Checks if the next append erases a sector that still holds entries
+ */
+bool tslog_append_will_reclaim(const tslog_t* log);
+
+/**
+ * @brief Checks if entry slot is unwritten
+ */
+bool tslog_entry_is_empty(const memory_entry_t* entry);
+
+/**
+ * @brief Attaches cursor to log and places it after the newest entry
+ */
+void tslog_cursor_init(tslog_cursor_t* cursor, tslog_t* log);
+
+/**
+ * @brief Places cursor at the oldest readable entry
+ */
+void tslog_cursor_rewind(tslog_cursor_t* cursor);
+
+/**
+ * @brief Returns cursor position, it can be restored later with tslog_cursor_restore()
+ */
+tslog_pos_t tslog_cursor_tell(const tslog_cursor_t* cursor);
+
+/**
+ * @brief Moves cursor back to saved position
+ */
+void tslog_cursor_restore(tslog_cursor_t* cursor, tslog_pos_t pos);
+
+/**
+ * @brief Checks if entry under cursor lies in the sector that will be erased by the next append
+ *        crossing a sector boundary, i.e. it is the next one to be reclaimed
+ */
+bool tslog_cursor_in_reclaim_sector(const tslog_cursor_t* cursor);
+
+/**
+ * @brief Places cursor at the newest entry with timestamp not later than given one
+ *
+ * @return true - positioned, false - timestamp is out of stored range, cursor is not moved
+ */
+bool tslog_cursor_seek(tslog_cursor_t* cursor, uint32_t timestamp);
+
+/**
+ * @brief Reads entries forward from cursor position and moves cursor after them
+ *
+ * @param values buffer for entry values
+ * @param timestamps buffer for entry timestamps, may be NULL
+ * @param count max number of entries to read
+ * @return uint16_t number of entries read
+ */
+uint16_t tslog_cursor_next(tslog_cursor_t* cursor, int32_t* values, uint32_t* timestamps, uint16_t count);
+
+/**
+ * @brief Reads entries preceding cursor position, newest first, and moves cursor back to the oldest read
+ *
+ * @param values buffer for entry values
+ * @param timestamps buffer for entry timestamps, may be NULL
+ * @param count max number of entries to read
+ * @return uint16_t number of entries read
+ */
+uint16_t tslog_cursor_prev(tslog_cursor_t* cursor, int32_t* values, uint32_t* timestamps, uint16_t count);
+
+/**
+ * @brief Finds the first entry since from_ts with value above threshold, pages which
+ *        zone maximum is not above threshold are skipped without reading
+ *
+ * @param found found entry, its value is decoded one
+ * @return true - found, false - no such entry stored
+ */
+bool tslog_find_first_above(tslog_cursor_t* cursor, uint32_t from_ts, int32_t threshold, memory_entry_t* found);
+
+/**
+ * @brief Finds entry with max value within [from_ts, to_ts], pages fully inside
+ *        the range contribute their zone maximum without reading
+ *
+ * @param found found entry, its value is decoded one
+ * @return true - found, false - no entries in range
+ */
+bool tslog_find_max(tslog_cursor_t* cursor, uint32_t from_ts, uint32_t to_ts, memory_entry_t* found);
@@ -0,0 +1,49 @@
+/**
+ * @file wear.h
+ * @brief Flash wear telemetry, per-sector erase and program counters
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define WEAR_MAX_SECTORS 24
+#define WEAR_SECTOR_ENDURANCE 100000
+#define WEAR_PERSIST_SECTORS 2
+#define WEAR_PERSIST_BYTES 16384    /**< Programmed bytes after which counters are saved */
+#define WEAR_PERSIST_PERIOD_S 3600  /**< Age of saved counters after which the next write saves them */
+
+/**
+ * @brief Starts counting erase/program operations of memory driver
+ * @note Wraps memory driver functions, shall be called after memory_init_driver()
+ *
+ * @param sector_count number of tracked sectors starting from address 0
+ * @param persist_addr first of two sectors used to keep counters, shall be among tracked ones
+ */
+void wear_init(uint16_t sector_count, uint32_t persist_addr);
+
+/**
+ * @brief Accounts bytes of application data, used as write amplification base
+ */
+void wear_account_payload(uint32_t bytes);
+
+/**
+ * @brief Returns accounted application bytes and physically programmed bytes since counting began
+ */
+void wear_get_bytes(uint32_t* payload_bytes, uint32_t* program_bytes);
+
+/**
+ * @brief Saves current counters to flash
+ * @note Called on every erase and on a write once WEAR_PERSIST_BYTES were programmed or
+ *       WEAR_PERSIST_PERIOD_S passed since the last save. Records are appended to one of two
+ *       sectors, the other one is erased only when it takes the next record, so the latest
+ *       saved record survives a reset at any point
+ */
+void wear_persist(void);
+
+/**
+ * @brief Logs counters, projected lifetime and write amplification
+ */
+void wear_report(void);
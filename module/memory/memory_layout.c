@@ -0,0 +1,37 @@
+/**
+ * @file memory_layout.c
+ * @brief Marker of flash layout version, flash written by another layout is erased before use
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "memory_layout.h"
+#include "memory.h"
+#include "slog.h"
+
+#define MEMORY_LAYOUT_MAGIC 0x4C41594F
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} memory_layout_marker_t;
+
+extern memory_driver_t memory;
+
+bool memory_layout_check(uint32_t marker_addr, uint32_t version, uint16_t sector_count) {
+    memory_layout_marker_t marker;
+    memory.read((uint8_t*)&marker, marker_addr, sizeof(marker));
+    if (marker.magic == MEMORY_LAYOUT_MAGIC && marker.version == version) {
+        return true;
+    }
+
+    /* Entries of an older layout would be decoded with a wrong format or looked up in a wrong region */
+    SLOG_WARN("memory: layout 0x%08X/%lu found, %lu expected, erasing %u sectors", marker.magic, marker.version,
+        version, sector_count);
+    for (uint16_t sector = 0; sector < sector_count; sector++) {
+        memory.erase_sector((uint32_t)sector * memory.sector_size);
+    }
+    marker = (memory_layout_marker_t){.magic = MEMORY_LAYOUT_MAGIC, .version = version};
+    memory.write((const uint8_t*)&marker, marker_addr, sizeof(marker));
+    return false;
+}
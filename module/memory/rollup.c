@@ -0,0 +1,120 @@
+/**
+ * @file rollup.c
+ * @brief Incremental compaction of old raw samples into coarse aggregates
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "rollup.h"
+#include "slog.h"
+#include <stddef.h>
+
+static void rollup_flush_bucket(rollup_job_t* job) {
+    if (job->bucket_count == 0) {
+        return;
+    }
+    memory_entry_t entry;
+    entry.timestamp = job->bucket_start;
+    entry.value = (int32_t)(job->bucket_sum / job->bucket_count);
+    tslog_append(job->rollup, &entry);
+    SLOG_DEBUG("rollup ts %lu from %u entries: %ld", entry.timestamp, job->bucket_count, entry.value);
+    job->bucket_sum = 0;
+    job->bucket_count = 0;
+}
+
+static void rollup_accumulate(rollup_job_t* job, uint32_t timestamp, int32_t value) {
+    uint32_t bucket_start = timestamp - timestamp % job->bucket_s;
+    if (job->bucket_count > 0 && bucket_start != job->bucket_start) {
+        rollup_flush_bucket(job);
+    }
+    job->bucket_start = bucket_start;
+    job->bucket_sum += value;
+    job->bucket_count++;
+}
+
+/**
+ * @brief Places job at the first raw entry after the newest stored bucket, entries before it are compacted already
+ */
+static void rollup_resume(rollup_job_t* job) {
+    int32_t value;
+    uint32_t newest_bucket;
+    tslog_cursor_init(&job->cursor, job->rollup);
+    bool has_buckets = tslog_cursor_prev(&job->cursor, &value, &newest_bucket, 1) == 1;
+
+    tslog_cursor_init(&job->cursor, job->raw);
+    if (!has_buckets) {
+        tslog_cursor_rewind(&job->cursor);
+        return;
+    }
+    const uint32_t compacted_until = newest_bucket + job->bucket_s;
+    if (tslog_cursor_seek(&job->cursor, compacted_until - 1)) {
+        tslog_cursor_next(&job->cursor, &value, NULL, 1);
+        return;
+    }
+    /* Out of raw range, either every raw entry is newer or every one is compacted */
+    uint32_t oldest;
+    tslog_cursor_rewind(&job->cursor);
+    tslog_pos_t pos = tslog_cursor_tell(&job->cursor);
+    if (tslog_cursor_next(&job->cursor, &value, &oldest, 1) == 1 && oldest >= compacted_until) {
+        tslog_cursor_restore(&job->cursor, pos);
+    } else {
+        tslog_cursor_init(&job->cursor, job->raw);
+    }
+}
+
+void rollup_job_init(rollup_job_t* job, tslog_t* raw, tslog_t* rollup, uint32_t min_age_s, uint32_t bucket_s) {
+    job->raw = raw;
+    job->rollup = rollup;
+    job->min_age_s = min_age_s;
+    job->bucket_s = bucket_s;
+    job->bucket_start = 0;
+    job->bucket_sum = 0;
+    job->bucket_count = 0;
+    rollup_resume(job);
+}
+
+/**
+ * @brief Compacts entries while they are eligible
+ *
+ * @param force_reclaim compact entries of reclaim sector regardless of their age
+ */
+static bool rollup_run(rollup_job_t* job, uint32_t now, uint16_t max_entries, bool force_reclaim) {
+    for (uint16_t i = 0; i < max_entries; i++) {
+        tslog_pos_t pos = tslog_cursor_tell(&job->cursor);
+        bool in_reclaim_sector = tslog_cursor_in_reclaim_sector(&job->cursor);
+        if (force_reclaim && !in_reclaim_sector) {
+            return false;
+        }
+
+        int32_t value;
+        uint32_t timestamp;
+        if (tslog_cursor_next(&job->cursor, &value, &timestamp, 1) == 0) {
+            if (job->cursor.addr != job->raw->write_addr || job->cursor.at_oldest) {
+                /* Writer has overtaken the job, continue from what is left */
+                SLOG_WARN("rollup job lost raw entries at 0x%06X", job->cursor.addr);
+                tslog_cursor_rewind(&job->cursor);
+            }
+            return false;
+        }
+
+        if (!force_reclaim && !in_reclaim_sector && now - timestamp < job->min_age_s) {
+            tslog_cursor_restore(&job->cursor, pos);
+            return false;
+        }
+        rollup_accumulate(job, timestamp, value);
+    }
+    return true;
+}
+
+bool rollup_job_step(rollup_job_t* job, uint32_t now, uint16_t max_entries) {
+    return rollup_run(job, now, max_entries, false);
+}
+
+void rollup_job_before_append(rollup_job_t* job, uint32_t now) {
+    if (!tslog_append_will_erase(job->raw)) {
+        return;
+    }
+    /* Open bucket stays open, its sum keeps the reclaimed entries and one entry per bucket is stored */
+    while (rollup_run(job, now, TSLOG_PAGE_ENTRIES, true)) {
+    }
+}
@@ -0,0 +1,402 @@
+/**
+ * @file tslog.c
+ * @brief Time-series log stored in flash ring buffer and cursor over it
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "tslog.h"
+#include "slog.h"
+#include <stddef.h>
+
+extern memory_driver_t memory;
+
+static uint32_t ring_next(const tslog_t* log, uint32_t addr) {
+    addr += sizeof(memory_entry_t);
+    if (addr >= log->start_addr + log->size) {
+        addr = log->start_addr;
+    }
+    return addr;
+}
+
+static uint32_t ring_prev(const tslog_t* log, uint32_t addr) {
+    if (addr == log->start_addr) {
+        addr = log->start_addr + log->size;
+    }
+    return addr - sizeof(memory_entry_t);
+}
+
+bool tslog_entry_is_empty(const memory_entry_t* entry) {
+    return entry->timestamp == 0xFFFFFFFF || entry->value == 0xFFFFFFFF;
+}
+
+static int32_t entry_value(const tslog_t* log, const memory_entry_t* entry) {
+    return log->decode ? log->decode(entry, log->decode_tag) : entry->value;
+}
+
+static uint32_t page_count(const tslog_t* log) {
+    return log->size / TSLOG_PAGE_SIZE;
+}
+
+static void zone_reset(tslog_zone_t* zone) {
+    zone->first_ts = 0xFFFFFFFF;
+    zone->last_ts = 0;
+    zone->min = INT32_MAX;
+    zone->max = INT32_MIN;
+}
+
+static bool zone_is_empty(const tslog_zone_t* zone) {
+    return zone->first_ts == 0xFFFFFFFF;
+}
+
+static void zone_update(tslog_zone_t* zone, uint32_t timestamp, int32_t value) {
+    if (zone_is_empty(zone)) {
+        zone->first_ts = timestamp;
+    }
+    zone->last_ts = timestamp;
+    if (value < zone->min) zone->min = value;
+    if (value > zone->max) zone->max = value;
+}
+
+void tslog_init(tslog_t* log, uint32_t start_addr, uint32_t size) {
+    if (size / TSLOG_PAGE_SIZE > TSLOG_MAX_PAGES) {
+        SLOG_ERROR("tslog 0x%06X size %lu exceeds zone map, truncated", start_addr, size);
+        size = TSLOG_MAX_PAGES * TSLOG_PAGE_SIZE;
+    }
+    log->start_addr = start_addr;
+    log->size = size;
+    log->write_addr = start_addr;
+    log->generation = 0;
+    log->decode = NULL;
+    log->decode_tag = 0;
+    for (uint32_t i = 0; i < TSLOG_MAX_PAGES; i++) {
+        zone_reset(&log->zones[i]);
+    }
+}
+
+void tslog_set_decoder(tslog_t* log, tslog_decode_func_t decode, uint8_t tag) {
+    log->decode = decode;
+    log->decode_tag = tag;
+}
+
+void tslog_scan(tslog_t* log) {
+    static memory_entry_t page[TSLOG_PAGE_ENTRIES];
+    bool write_addr_found = false;
+    /* Ring filled up to a sector boundary has no free slot, its oldest sector starts older than the entry before it */
+    uint32_t oldest_sector = log->start_addr;
+    bool oldest_sector_found = false;
+    uint32_t prev_ts = 0;
+    log->write_addr = log->start_addr;
+    for (uint32_t p = 0; p < page_count(log); p++) {
+        uint32_t addr = log->start_addr + p * TSLOG_PAGE_SIZE;
+        memory.read((uint8_t*)page, addr, TSLOG_PAGE_SIZE);
+        zone_reset(&log->zones[p]);
+        for (uint32_t i = 0; i < TSLOG_PAGE_ENTRIES; i++) {
+            if (!tslog_entry_is_empty(&page[i])) {
+                zone_update(&log->zones[p], page[i].timestamp, entry_value(log, &page[i]));
+                if (!oldest_sector_found && i == 0 && (addr - log->start_addr) % memory.sector_size == 0
+                    && page[i].timestamp < prev_ts) {
+                    oldest_sector_found = true;
+                    oldest_sector = addr;
+                }
+                prev_ts = page[i].timestamp;
+            } else if (!write_addr_found) {
+                write_addr_found = true;
+                log->write_addr = addr + i * sizeof(memory_entry_t);
+            }
+        }
+    }
+    if (!write_addr_found) {
+        log->write_addr = oldest_sector;
+    }
+    SLOG_DEBUG("tslog 0x%06X, addr to write 0x%06X", log->start_addr, log->write_addr);
+    log->generation++;
+}
+
+bool tslog_append_will_erase(const tslog_t* log) {
+    return (log->write_addr - log->start_addr) % memory.sector_size == 0;
+}
+
+bool tslog_append_will_reclaim(const tslog_t* log) {
+    if (!tslog_append_will_erase(log)) {
+        return false;
+    }
+    memory_entry_t entry;
+    memory.read(entry.raw, log->write_addr, sizeof(entry));
+    return !tslog_entry_is_empty(&entry);
+}
+
+void tslog_append(tslog_t* log, const memory_entry_t* entry) {
+    const uint32_t page = (log->write_addr - log->start_addr) / TSLOG_PAGE_SIZE;
+    if (tslog_append_will_erase(log)) {
+        memory.erase_sector(log->write_addr);
+        for (uint32_t i = 0; i < memory.sector_size / TSLOG_PAGE_SIZE; i++) {
+            zone_reset(&log->zones[page + i]);
+        }
+    }
+    memory.write(entry->raw, log->write_addr, sizeof(*entry));
+    zone_update(&log->zones[page], entry->timestamp, entry_value(log, entry));
+    SLOG_DEBUG("tslog 0x%06X, entry saved at 0x%06X", log->start_addr, log->write_addr);
+    log->write_addr = ring_next(log, log->write_addr);
+    log->generation++;
+}
+
+/**
+ * @brief Returns entry at addr, loading its page into cursor cache if needed
+ */
+static const memory_entry_t* cursor_entry(tslog_cursor_t* cursor, uint32_t addr) {
+    uint32_t page_addr = addr - (addr % TSLOG_PAGE_SIZE);
+    if (cursor->cache_addr != page_addr || cursor->cache_generation != cursor->log->generation) {
+        memory.read((uint8_t*)cursor->cache, page_addr, TSLOG_PAGE_SIZE);
+        cursor->cache_addr = page_addr;
+        cursor->cache_generation = cursor->log->generation;
+    }
+    return &cursor->cache[(addr - page_addr) / sizeof(memory_entry_t)];
+}
+
+/**
+ * @brief Tells whether ring has wrapped onto a not yet erased sector, its oldest entry is then under write_addr
+ */
+static bool ring_is_wrapped(tslog_cursor_t* cursor) {
+    return !tslog_entry_is_empty(cursor_entry(cursor, cursor->log->write_addr));
+}
+
+/**
+ * @brief Finds the oldest readable entry
+ */
+static uint32_t cursor_oldest_addr(tslog_cursor_t* cursor) {
+    const tslog_t* log = cursor->log;
+    if (ring_is_wrapped(cursor)) {
+        return log->write_addr;
+    }
+    uint32_t next_sector = log->write_addr - (log->write_addr - log->start_addr) % memory.sector_size + memory.sector_size;
+    if (next_sector >= log->start_addr + log->size) {
+        next_sector = log->start_addr;
+    }
+    if (next_sector != log->write_addr && !tslog_entry_is_empty(cursor_entry(cursor, next_sector))) {
+        return next_sector;
+    }
+    return log->start_addr;
+}
+
+/**
+ * @brief Places cursor at addr, write_addr of a wrapped ring is taken as its oldest entry
+ */
+static void cursor_place_at_entry(tslog_cursor_t* cursor, uint32_t addr) {
+    cursor->addr = addr;
+    cursor->at_oldest = addr == cursor->log->write_addr && ring_is_wrapped(cursor);
+}
+
+/**
+ * @brief Tells whether cursor is at the end, that is after the newest entry
+ */
+static bool cursor_at_end(const tslog_cursor_t* cursor) {
+    return cursor->addr == cursor->log->write_addr && !cursor->at_oldest;
+}
+
+void tslog_cursor_init(tslog_cursor_t* cursor, tslog_t* log) {
+    cursor->log = log;
+    cursor->addr = log->write_addr;
+    cursor->at_oldest = false;
+    cursor->cache_addr = UINT32_MAX;
+    cursor->cache_generation = log->generation;
+}
+
+void tslog_cursor_rewind(tslog_cursor_t* cursor) {
+    cursor_place_at_entry(cursor, cursor_oldest_addr(cursor));
+}
+
+tslog_pos_t tslog_cursor_tell(const tslog_cursor_t* cursor) {
+    return (tslog_pos_t){cursor->addr, cursor->at_oldest};
+}
+
+void tslog_cursor_restore(tslog_cursor_t* cursor, tslog_pos_t pos) {
+    cursor->addr = pos.addr;
+    cursor->at_oldest = pos.at_oldest;
+}
+
+bool tslog_cursor_in_reclaim_sector(const tslog_cursor_t* cursor) {
+    const tslog_t* log = cursor->log;
+    uint32_t write_offset = log->write_addr - log->start_addr;
+    uint32_t reclaim_sector = write_offset - write_offset % memory.sector_size;
+    if (write_offset % memory.sector_size != 0) {
+        reclaim_sector = (reclaim_sector + memory.sector_size) % log->size;
+    }
+    uint32_t cursor_offset = cursor->addr - log->start_addr;
+    return cursor_offset - cursor_offset % memory.sector_size == reclaim_sector;
+}
+
+bool tslog_cursor_seek(tslog_cursor_t* cursor, uint32_t timestamp) {
+    const tslog_t* log = cursor->log;
+    const uint32_t oldest = cursor_oldest_addr(cursor);
+    uint32_t count = ((log->write_addr + log->size - oldest) % log->size) / sizeof(memory_entry_t);
+    if (oldest == log->write_addr && ring_is_wrapped(cursor)) {
+        count = log->size / sizeof(memory_entry_t);
+    }
+    if (count == 0) {
+        SLOG_DEBUG("tslog 0x%06X is empty, target ts: %lu", log->start_addr, timestamp);
+        return false;
+    }
+
+    const memory_entry_t* newest = cursor_entry(cursor, ring_prev(log, log->write_addr));
+    if (tslog_entry_is_empty(newest) || timestamp > newest->timestamp) {
+        SLOG_DEBUG("tslog 0x%06X, ts %lu too new", log->start_addr, timestamp);
+        return false;
+    }
+
+    /* Binary search for the last entry with timestamp <= target, entries are stored in time order */
+    uint32_t low = 0, high = count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        uint32_t addr = log->start_addr + (oldest - log->start_addr + mid * sizeof(memory_entry_t)) % log->size;
+        const memory_entry_t* entry = cursor_entry(cursor, addr);
+        if (!tslog_entry_is_empty(entry) && entry->timestamp <= timestamp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0) {
+        SLOG_DEBUG("tslog 0x%06X, ts %lu too old", log->start_addr, timestamp);
+        return false;
+    }
+
+    cursor_place_at_entry(cursor, log->start_addr + (oldest - log->start_addr + (low - 1) * sizeof(memory_entry_t)) % log->size);
+    return true;
+}
+
+uint16_t tslog_cursor_next(tslog_cursor_t* cursor, int32_t* values, uint32_t* timestamps, uint16_t count) {
+    const tslog_t* log = cursor->log;
+    uint16_t read = 0;
+    while (read < count && !cursor_at_end(cursor)) {
+        const memory_entry_t* entry = cursor_entry(cursor, cursor->addr);
+        if (tslog_entry_is_empty(entry)) {
+            break;
+        }
+        values[read] = entry_value(log, entry);
+        if (timestamps) {
+            timestamps[read] = entry->timestamp;
+        }
+        read++;
+        cursor->addr = ring_next(log, cursor->addr);
+        cursor->at_oldest = false;
+    }
+    return read;
+}
+
+uint16_t tslog_cursor_prev(tslog_cursor_t* cursor, int32_t* values, uint32_t* timestamps, uint16_t count) {
+    const tslog_t* log = cursor->log;
+    const uint32_t oldest = cursor_oldest_addr(cursor);
+    uint16_t read = 0;
+    while (read < count && !(cursor->addr == oldest && (oldest != log->write_addr || cursor->at_oldest))) {
+        uint32_t addr = ring_prev(log, cursor->addr);
+        const memory_entry_t* entry = cursor_entry(cursor, addr);
+        if (tslog_entry_is_empty(entry)) {
+            break;
+        }
+        values[read] = entry_value(log, entry);
+        if (timestamps) {
+            timestamps[read] = entry->timestamp;
+        }
+        read++;
+        cursor_place_at_entry(cursor, addr);
+    }
+    return read;
+}
+
+/**
+ * @brief Page index of the oldest page, pages are visited in time order starting from it
+ */
+static uint32_t oldest_page(const tslog_t* log) {
+    const uint32_t write_offset = log->write_addr - log->start_addr;
+    if (write_offset % TSLOG_PAGE_SIZE == 0) {
+        return write_offset / TSLOG_PAGE_SIZE;
+    }
+    return (write_offset / TSLOG_PAGE_SIZE + 1) % page_count(log);
+}
+
+bool tslog_find_first_above(tslog_cursor_t* cursor, uint32_t from_ts, int32_t threshold, memory_entry_t* found) {
+    const tslog_t* log = cursor->log;
+    const uint32_t pages = page_count(log);
+    const uint32_t first_page = oldest_page(log);
+    for (uint32_t n = 0; n < pages; n++) {
+        const uint32_t p = (first_page + n) % pages;
+        const tslog_zone_t* zone = &log->zones[p];
+        if (zone_is_empty(zone) || zone->last_ts < from_ts || zone->max <= threshold) {
+            continue;
+        }
+        const uint32_t page_addr = log->start_addr + p * TSLOG_PAGE_SIZE;
+        for (uint32_t i = 0; i < TSLOG_PAGE_ENTRIES; i++) {
+            const memory_entry_t* entry = cursor_entry(cursor, page_addr + i * sizeof(memory_entry_t));
+            if (tslog_entry_is_empty(entry)) {
+                break;
+            }
+            if (entry->timestamp >= from_ts && entry_value(log, entry) > threshold) {
+                found->timestamp = entry->timestamp;
+                found->value = entry_value(log, entry);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool tslog_find_max(tslog_cursor_t* cursor, uint32_t from_ts, uint32_t to_ts, memory_entry_t* found) {
+    const tslog_t* log = cursor->log;
+    int32_t best_value = INT32_MIN;
+    int32_t best_page = -1;
+    bool found_is_set = false;
+
+    for (uint32_t p = 0; p < page_count(log); p++) {
+        const tslog_zone_t* zone = &log->zones[p];
+        if (zone_is_empty(zone) || zone->last_ts < from_ts || zone->first_ts > to_ts) {
+            continue;
+        }
+        const bool fully_inside = zone->first_ts >= from_ts && zone->last_ts <= to_ts;
+        if (fully_inside) {
+            if (zone->max > best_value) {
+                best_value = zone->max;
+                best_page = p;
+                found_is_set = false;
+            }
+            continue;
+        }
+        if (zone->max <= best_value) {
+            continue;
+        }
+        /* Partially overlapping page, only entries within range count */
+        const uint32_t page_addr = log->start_addr + p * TSLOG_PAGE_SIZE;
+        for (uint32_t i = 0; i < TSLOG_PAGE_ENTRIES; i++) {
+            const memory_entry_t* entry = cursor_entry(cursor, page_addr + i * sizeof(memory_entry_t));
+            if (tslog_entry_is_empty(entry)) {
+                break;
+            }
+            if (entry->timestamp >= from_ts && entry->timestamp <= to_ts && entry_value(log, entry) > best_value) {
+                best_value = entry_value(log, entry);
+                best_page = p;
+                found_is_set = true;
+                found->timestamp = entry->timestamp;
+                found->value = best_value;
+            }
+        }
+    }
+
+    if (best_page < 0) {
+        return false;
+    }
+    if (found_is_set) {
+        return true;
+    }
+
+    /* Read the winning page once to get timestamp of its maximum */
+    const uint32_t page_addr = log->start_addr + best_page * TSLOG_PAGE_SIZE;
+    for (uint32_t i = 0; i < TSLOG_PAGE_ENTRIES; i++) {
+        const memory_entry_t* entry = cursor_entry(cursor, page_addr + i * sizeof(memory_entry_t));
+        if (!tslog_entry_is_empty(entry) && entry_value(log, entry) == best_value) {
+            found->timestamp = entry->timestamp;
+            found->value = best_value;
+            return true;
+        }
+    }
+    return false;
+}
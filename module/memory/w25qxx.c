@@ -21,6 +21,8 @@
 
 memory_driver_t memory;
 static volatile bool dma_busy = false;
+/* Archivist writes and erases while replay and history readers share the chip */
+static osMutexId_t flash_lock;
 
 static void wait_dma_ready(void) {
     while (dma_busy) {
@@ -47,6 +49,7 @@ static void w25qxx_wait_busy(void) {
 }
 
 static void w25qxx_read(uint8_t* buf, uint32_t addr, uint32_t len) {
+    osMutexAcquire(flash_lock, osWaitForever);
     wait_dma_ready();
 
     uint8_t cmd[4] = {
@@ -62,9 +65,11 @@ static void w25qxx_read(uint8_t* buf, uint32_t addr, uint32_t len) {
     HAL_SPI_Receive_DMA(&memory_spi, buf, len);
     wait_dma_ready();
     HAL_GPIO_WritePin(FLSH_CS_GPIO_Port, FLSH_CS_Pin, GPIO_PIN_SET);
+    osMutexRelease(flash_lock);
 }
 
 static void w25qxx_write(const uint8_t* buf, uint32_t addr, uint32_t len) {
+    osMutexAcquire(flash_lock, osWaitForever);
     wait_dma_ready();
 
     while (len > 0) {
@@ -93,9 +98,11 @@ static void w25qxx_write(const uint8_t* buf, uint32_t addr, uint32_t len) {
         buf += bytes_to_write;
         len -= bytes_to_write;
     }
+    osMutexRelease(flash_lock);
 }
 
 static void w25qxx_erase_sector(uint32_t addr) {
+    osMutexAcquire(flash_lock, osWaitForever);
     w25qxx_write_enable();
 
     uint8_t cmd[4] = {
@@ -110,9 +117,11 @@ static void w25qxx_erase_sector(uint32_t addr) {
     HAL_GPIO_WritePin(FLSH_CS_GPIO_Port, FLSH_CS_Pin, GPIO_PIN_SET);
 
     w25qxx_wait_busy();
+    osMutexRelease(flash_lock);
 }
 
 static void w25qxx_erase_chip(void) {
+    osMutexAcquire(flash_lock, osWaitForever);
     w25qxx_write_enable();
     uint8_t cmd = W25QXX_CMD_CHIP_ERASE;
 
@@ -121,16 +130,19 @@ static void w25qxx_erase_chip(void) {
     HAL_GPIO_WritePin(FLSH_CS_GPIO_Port, FLSH_CS_Pin, GPIO_PIN_SET);
 
     w25qxx_wait_busy();
+    osMutexRelease(flash_lock);
 }
 
 static uint32_t w25qxx_get_id(void) {
     uint8_t cmd = W25QXX_CMD_READ_ID;
     uint8_t id[3];
 
+    osMutexAcquire(flash_lock, osWaitForever);
     HAL_GPIO_WritePin(FLSH_CS_GPIO_Port, FLSH_CS_Pin, GPIO_PIN_RESET);
     HAL_SPI_Transmit(&memory_spi, &cmd, 1, HAL_MAX_DELAY);
     HAL_SPI_Receive(&memory_spi, id, 3, HAL_MAX_DELAY);
     HAL_GPIO_WritePin(FLSH_CS_GPIO_Port, FLSH_CS_Pin, GPIO_PIN_SET);
+    osMutexRelease(flash_lock);
 
     return (id[0] << 16) | (id[1] << 8) | id[2];
 }
@@ -140,6 +152,7 @@ static bool w25qxx_init(void) {
 }
 
 void memory_init_driver(void) {
+    flash_lock = osMutexNew(NULL);
     memory.init = w25qxx_init;
     memory.read = w25qxx_read;
     memory.write = w25qxx_write;
@@ -0,0 +1,210 @@
+/**
+ * @file wear.c
+ * @brief Flash wear telemetry, per-sector erase and program counters
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "wear.h"
+#include "memory.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define WEAR_RECORD_MAGIC 0x57454152
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t checksum;
+    uint32_t uptime_s;      /**< Accumulated uptime while counting */
+    uint32_t payload_bytes; /**< Application data bytes */
+    uint32_t program_bytes; /**< Physically programmed bytes */
+    uint32_t erase_count[WEAR_MAX_SECTORS];
+    uint32_t program_count[WEAR_MAX_SECTORS];
+} wear_record_t;
+
+extern memory_driver_t memory;
+
+static void (*driver_write)(const uint8_t* buf, uint32_t addr, uint32_t len);
+static void (*driver_erase_sector)(uint32_t addr);
+
+static wear_record_t counters;
+static uint16_t tracked_sectors = 0;
+static uint32_t persist_area_addr;   /**< First of persist sectors, records are appended to one of them */
+static uint32_t persist_sector_addr; /**< Sector holding the latest record */
+static uint32_t persist_write_addr;
+static uint32_t persisted_program_bytes;
+static uint32_t persisted_uptime_s;
+static uint32_t boot_uptime_s;
+
+static uint32_t record_checksum(const wear_record_t* record) {
+    const uint32_t* words = (const uint32_t*)record;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < sizeof(*record) / sizeof(uint32_t); i++) {
+        if (&words[i] != &record->checksum) {
+            sum = (sum << 1 | sum >> 31) ^ words[i];
+        }
+    }
+    return sum;
+}
+
+static uint32_t uptime_now_s(void) {
+    return boot_uptime_s + osKernelGetTickCount() / osKernelGetTickFreq();
+}
+
+static int32_t sector_index(uint32_t addr) {
+    uint32_t index = addr / memory.sector_size;
+    return (index < tracked_sectors) ? (int32_t)index : -1;
+}
+
+static bool is_persist_sector(uint32_t addr) {
+    return addr >= persist_area_addr && addr < persist_area_addr + WEAR_PERSIST_SECTORS * memory.sector_size;
+}
+
+static void wear_program(const uint8_t* buf, uint32_t addr, uint32_t len) {
+    driver_write(buf, addr, len);
+    int32_t index = sector_index(addr);
+    if (index >= 0) {
+        counters.program_count[index]++;
+        counters.program_bytes += len;
+    }
+}
+
+static void wear_erase(uint32_t addr) {
+    driver_erase_sector(addr);
+    int32_t index = sector_index(addr);
+    if (index >= 0) {
+        counters.erase_count[index]++;
+    }
+}
+
+static void wear_write(const uint8_t* buf, uint32_t addr, uint32_t len) {
+    wear_program(buf, addr, len);
+    if (counters.program_bytes - persisted_program_bytes >= WEAR_PERSIST_BYTES
+        || uptime_now_s() - persisted_uptime_s >= WEAR_PERSIST_PERIOD_S) {
+        wear_persist();
+    }
+}
+
+static void wear_erase_sector(uint32_t addr) {
+    wear_erase(addr);
+    if (!is_persist_sector(addr)) {
+        wear_persist();
+    }
+}
+
+/**
+ * @brief Finds the latest valid record in persist sector and the slot after the last written one
+ */
+static void wear_restore(uint32_t sector_addr) {
+    for (uint32_t addr = sector_addr; addr + sizeof(wear_record_t) <= sector_addr + memory.sector_size; addr += sizeof(wear_record_t)) {
+        wear_record_t record;
+        memory.read((uint8_t*)&record, addr, sizeof(record));
+        if (record.magic == 0xFFFFFFFF) {
+            break;
+        }
+        if (record.magic == WEAR_RECORD_MAGIC && record.checksum == record_checksum(&record)
+            && record.sequence >= counters.sequence) {
+            counters = record;
+            persist_sector_addr = sector_addr;
+            persist_write_addr = addr + sizeof(wear_record_t);
+        } else if (persist_sector_addr == sector_addr) {
+            persist_write_addr = addr + sizeof(wear_record_t);
+        }
+    }
+}
+
+void wear_init(uint16_t sector_count, uint32_t persist_addr) {
+    if (sector_count > WEAR_MAX_SECTORS) {
+        SLOG_ERROR("wear: %u sectors requested, tracking first %u", sector_count, WEAR_MAX_SECTORS);
+        sector_count = WEAR_MAX_SECTORS;
+    }
+    tracked_sectors = sector_count;
+    persist_area_addr = persist_addr;
+    persist_sector_addr = persist_addr;
+    persist_write_addr = persist_addr;
+    memset(&counters, 0, sizeof(counters));
+
+    /* Records are appended to one sector until it is full, the latest one may be in either sector */
+    for (uint8_t i = 0; i < WEAR_PERSIST_SECTORS; i++) {
+        wear_restore(persist_addr + i * memory.sector_size);
+    }
+    boot_uptime_s = counters.uptime_s;
+    persisted_program_bytes = counters.program_bytes;
+    persisted_uptime_s = counters.uptime_s;
+    SLOG_INFO("wear: restored record #%lu, uptime %lus", counters.sequence, counters.uptime_s);
+
+    driver_write = memory.write;
+    driver_erase_sector = memory.erase_sector;
+    memory.write = wear_write;
+    memory.erase_sector = wear_erase_sector;
+}
+
+void wear_account_payload(uint32_t bytes) {
+    counters.payload_bytes += bytes;
+}
+
+void wear_get_bytes(uint32_t* payload_bytes, uint32_t* program_bytes) {
+    *payload_bytes = counters.payload_bytes;
+    *program_bytes = counters.program_bytes;
+}
+
+void wear_persist(void) {
+    if (tracked_sectors == 0) {
+        return;
+    }
+    if (persist_write_addr + sizeof(wear_record_t) > persist_sector_addr + memory.sector_size) {
+        /* The other sector takes the record, the full one keeps the previous record until the next switch */
+        persist_sector_addr = persist_area_addr + (persist_sector_addr - persist_area_addr + memory.sector_size)
+            % (WEAR_PERSIST_SECTORS * memory.sector_size);
+        wear_erase(persist_sector_addr);
+        persist_write_addr = persist_sector_addr;
+    }
+
+    /* Record accounts its own programming, restored counters then match the ones at the time of saving */
+    int32_t index = sector_index(persist_write_addr);
+    if (index >= 0) {
+        counters.program_count[index]++;
+        counters.program_bytes += sizeof(counters);
+    }
+    counters.magic = WEAR_RECORD_MAGIC;
+    counters.sequence++;
+    counters.uptime_s = uptime_now_s();
+    counters.checksum = record_checksum(&counters);
+    driver_write((const uint8_t*)&counters, persist_write_addr, sizeof(counters));
+    persist_write_addr += sizeof(wear_record_t);
+    persisted_program_bytes = counters.program_bytes;
+    persisted_uptime_s = counters.uptime_s;
+    SLOG_DEBUG("wear: record #%lu saved, payload %luB programmed %luB", counters.sequence, counters.payload_bytes, counters.program_bytes);
+}
+
+void wear_report(void) {
+    uint32_t uptime_s = uptime_now_s();
+    uint32_t max_erases = 0;
+    uint64_t erased_bytes = 0;
+    for (uint16_t i = 0; i < tracked_sectors; i++) {
+        SLOG_INFO("wear: sector %2u erases %lu programs %lu", i, counters.erase_count[i], counters.program_count[i]);
+        erased_bytes += (uint64_t)counters.erase_count[i] * memory.sector_size;
+        if (counters.erase_count[i] > max_erases) {
+            max_erases = counters.erase_count[i];
+        }
+    }
+
+    if (max_erases > 0 && max_erases < WEAR_SECTOR_ENDURANCE) {
+        /* Most worn sector keeps its average erase rate until endurance limit */
+        uint64_t days_left = (uint64_t)(WEAR_SECTOR_ENDURANCE - max_erases) * uptime_s / max_erases / 86400;
+        SLOG_INFO("wear: max erases %lu/%u, projected lifetime %lu days", max_erases, WEAR_SECTOR_ENDURANCE, (uint32_t)days_left);
+    } else {
+        SLOG_INFO("wear: max erases %lu/%u, no projection", max_erases, WEAR_SECTOR_ENDURANCE);
+    }
+
+    if (counters.payload_bytes > 0) {
+        /* Amplification in hundredths: programmed and erased bytes per application byte */
+        uint32_t program_wa = (uint32_t)((uint64_t)counters.program_bytes * 100 / counters.payload_bytes);
+        uint32_t erase_wa = (uint32_t)(erased_bytes * 100 / counters.payload_bytes);
+        SLOG_INFO("wear: payload %luB programmed %luB, WA program %lu.%02lu erase %lu.%02lu",
+            counters.payload_bytes, counters.program_bytes, program_wa / 100, program_wa % 100, erase_wa / 100, erase_wa % 100);
+    }
+}
@@ -15,14 +15,18 @@ static lv_obj_t* history_screen_main_container;
 static lv_obj_t* date_dropdown;
 static lv_obj_t* hour_dropdown;
 static lv_obj_t* show_button;
+static lv_obj_t* prev_button;
+static lv_obj_t* next_button;
 static lv_obj_t* data_display_area_container;
 static lv_obj_t* history_charts[SENSOR_TYPE_COUNT];
 static lv_chart_series_t* history_chart_series[SENSOR_TYPE_COUNT];
+/* Chart external y arrays, history data is fetched directly into them */
+static int32_t history_chart_points[SENSOR_TYPE_COUNT][HISTORY_CHART_POINTS];
 
 static char date_options_str[HISTORY_MAX_DATE_OPTIONS * 12];
 static RTC_DateTypeDef selected_dates[HISTORY_MAX_DATE_OPTIONS];
 
-history_data_fetcher_t history_data_fetcher_func;
+static const history_data_source_t* history_data_source;
 
 static bool screen_is_currently_active = false;
 
@@ -106,8 +110,91 @@ static void show_button_event_cb(lv_event_t* e) {
     }
 }
 
+static void update_history_chart_range(sensor_data_type_t type) {
+    const int32_t* points = history_chart_points[type];
+    int32_t min_y = LV_COORD_MAX, max_y = LV_COORD_MIN;
+    for (uint16_t i = 0; i < HISTORY_CHART_POINTS; i++) {
+        if (points[i] == LV_CHART_POINT_NONE) {
+            continue;
+        }
+        if (points[i] < min_y) min_y = points[i];
+        if (points[i] > max_y) max_y = points[i];
+    }
+
+    lv_chart_set_range(history_charts[type], LV_CHART_AXIS_PRIMARY_Y, (lv_coord_t)min_y, (lv_coord_t)max_y);
+    lv_chart_refresh(history_charts[type]);
+}
+
+/**
+ * @brief Adds label with the max value stored over HISTORY_PEAK_PERIOD_S preceding end_ts
+ *
+ * @return true - label added, false - no data stored for the period
+ */
+static bool create_peak_label(lv_obj_t* parent, sensor_data_type_t type, uint32_t end_ts) {
+    int32_t value;
+    uint32_t timestamp;
+    if (!history_data_source->peak || !history_data_source->peak(type, end_ts - HISTORY_PEAK_PERIOD_S, end_ts, &value, &timestamp)) {
+        return false;
+    }
+
+    lv_obj_t* peak_label = lv_label_create(parent);
+    switch (type) {
+        case SENSOR_TEMPERATURE:
+            lv_label_set_text_fmt(peak_label, "max %ld.%01ld°C", value / 100, (value % 100) / 10);
+            break;
+        case SENSOR_HUMIDITY:
+            lv_label_set_text_fmt(peak_label, "max %ld.%01ld%%", value / 100, (value % 100) / 10);
+            break;
+        case SENSOR_PRESSURE:
+            lv_label_set_text_fmt(peak_label, "max %ldhPa", value / 100);
+            break;
+        case SENSOR_TVOC:
+            lv_label_set_text_fmt(peak_label, "max %ldppb", value);
+            break;
+        default:
+            lv_label_set_text(peak_label, "");
+            break;
+    }
+    lv_obj_set_style_text_font(peak_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(peak_label, lv_palette_main(LV_PALETTE_RED), 0);
+    lv_obj_align(peak_label, LV_ALIGN_BOTTOM_MID, 0, 0);
+    return true;
+}
+
+static void pan_button_event_cb(lv_event_t* e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED || !history_data_source) {
+        return;
+    }
+    bool forward = (lv_event_get_target(e) == next_button);
+    for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        if (!history_charts[type]) {
+            continue;
+        }
+        uint16_t loaded;
+        if (forward) {
+            loaded = history_data_source->next(type, history_chart_points[type], HISTORY_CHART_POINTS);
+        } else {
+            loaded = history_data_source->prev(type, history_chart_points[type], HISTORY_CHART_POINTS);
+        }
+        if (loaded > 0) {
+            update_history_chart_range(type);
+        }
+    }
+}
+
+static lv_obj_t* create_pan_button(lv_obj_t* parent, const char* text) {
+    lv_obj_t* button = lv_btn_create(parent);
+    lv_obj_set_width(button, 40);
+    lv_obj_t* label = lv_label_create(button);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    lv_obj_add_event_cb(button, pan_button_event_cb, LV_EVENT_CLICKED, NULL);
+    return button;
+}
+
 static void display_fetched_history_data(RTC_DateTypeDef date_bcd, uint8_t hour) {
-    if (!history_data_fetcher_func || !data_display_area_container) {
+    if (!history_data_source || !data_display_area_container) {
         lv_obj_t* temp_label = lv_label_create(data_display_area_container);
         lv_label_set_text_fmt(temp_label,
             "History fetcher not available or UI error.\nSelected: %02x.%02x.20%02x, %02d:00", date_bcd.Date, date_bcd.Month, date_bcd.Year, hour);
@@ -116,9 +203,9 @@ static void display_fetched_history_data(RTC_DateTypeDef date_bcd, uint8_t hour)
     }
 
     uint32_t timestamp_hour_start = datetime_to_timestamp(2000 + date_bcd.Year, date_bcd.Month, date_bcd.Date, hour, 0, 0);
-    int32_t fetched_values[HISTORY_CHART_POINTS];
     for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
-        history_data_fetcher_func(type, timestamp_hour_start, fetched_values, HISTORY_CHART_POINTS);
+        int32_t* points = history_chart_points[type];
+        history_data_source->seek(type, timestamp_hour_start, points, HISTORY_CHART_POINTS);
 
         lv_obj_t* chart_block = lv_obj_create(data_display_area_container);
         lv_obj_remove_style_all(chart_block);
@@ -160,6 +247,9 @@ static void display_fetched_history_data(RTC_DateTypeDef date_bcd, uint8_t hour)
         }
         lv_obj_set_style_text_font(name_label, &lv_font_montserrat_14, 0);
         lv_obj_center(name_label);
+        if (create_peak_label(name_label_cont, type, timestamp_hour_start + 3600)) {
+            lv_obj_align(name_label, LV_ALIGN_TOP_MID, 0, 0);
+        }
 
         history_charts[type] = lv_chart_create(chart_block);
         lv_obj_set_style_flex_grow(history_charts[type], 1, 0);
@@ -171,19 +261,8 @@ static void display_fetched_history_data(RTC_DateTypeDef date_bcd, uint8_t hour)
         lv_obj_set_style_bg_color(history_charts[type], lv_color_hex(0xF0F0F0), 0);
 
         history_chart_series[type] = lv_chart_add_series(history_charts[type], lv_palette_main(LV_PALETTE_BLUE_GREY), LV_CHART_AXIS_PRIMARY_Y);
-
-        int32_t min_y = LV_COORD_MAX, max_y = LV_COORD_MIN;
-        for (uint16_t i = 0; i < HISTORY_CHART_POINTS; i++) {
-            lv_chart_set_next_value(history_charts[type], history_chart_series[type], fetched_values[i]);
-            if (fetched_values[i] == LV_CHART_POINT_NONE) {
-                continue;
-            }
-            if (fetched_values[i] < min_y) min_y = fetched_values[i];
-            if (fetched_values[i] > max_y) max_y = fetched_values[i];
-        }
-
-        lv_chart_set_range(history_charts[type], LV_CHART_AXIS_PRIMARY_Y, (lv_coord_t)min_y, (lv_coord_t)max_y);
-        lv_chart_refresh(history_charts[type]);
+        lv_chart_set_ext_y_array(history_charts[type], history_chart_series[type], points);
+        update_history_chart_range(type);
     }
 }
 
@@ -240,12 +319,16 @@ void gui_history_screen_create(lv_obj_t* parent_of_screens_base_layer) {
     lv_obj_set_width(hour_dropdown, 70);
     fill_hour_dropdown();
 
+    prev_button = create_pan_button(controls_cont, LV_SYMBOL_LEFT);
+
     show_button = lv_btn_create(controls_cont);
     lv_obj_t* btn_label = lv_label_create(show_button);
     lv_label_set_text(btn_label, "Display");
     lv_obj_center(btn_label);
     lv_obj_add_event_cb(show_button, show_button_event_cb, LV_EVENT_CLICKED, NULL);
 
+    next_button = create_pan_button(controls_cont, LV_SYMBOL_RIGHT);
+
     data_display_area_container = lv_obj_create(history_screen_main_container);
     lv_obj_remove_style_all(data_display_area_container);
     lv_obj_set_width(data_display_area_container, lv_pct(100));
@@ -280,6 +363,8 @@ void gui_history_screen_destroy(void) {
     date_dropdown = NULL;
     hour_dropdown = NULL;
     show_button = NULL;
+    prev_button = NULL;
+    next_button = NULL;
     data_display_area_container = NULL;
     for (int i = 0; i < SENSOR_TYPE_COUNT; ++i) {
         history_charts[i] = NULL;
@@ -292,6 +377,6 @@ bool gui_history_screen_is_active(void) {
     return screen_is_currently_active;
 }
 
-void gui_history_init_data_fetcher(history_data_fetcher_t data_fetcher_func) {
-    history_data_fetcher_func = data_fetcher_func;
+void gui_history_init_data_source(const history_data_source_t* data_source) {
+    history_data_source = data_source;
 }
@@ -6,6 +6,7 @@
  */
 
 #include "gui.h"
+#include "fusion.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -20,7 +21,8 @@ typedef struct {
     lv_obj_t* label_name;       /**< Sensor name (e.g., "Temperature") */
     lv_obj_t* label_curr_value; /**< Current sensor value string */
     lv_obj_t* chart;
-    lv_chart_series_t* series;
+    lv_chart_series_t* series;  /**< Fused value of the quantity */
+    lv_chart_series_t* source_series[FUSION_MAX_SOURCES]; /**< Multi-source quantities only */
 } sensor_chart_ui_t;
 
 /**
@@ -29,6 +31,8 @@ typedef struct {
 typedef struct {
     int32_t values[SENSOR_MONITOR_MAX_POINTS];
     uint8_t data_point_count;
+    int32_t source_values[FUSION_MAX_SOURCES][SENSOR_MONITOR_MAX_POINTS];
+    uint8_t source_point_count[FUSION_MAX_SOURCES];
     int32_t last_known_value;
     bool has_ever_received_data;
 } sensor_persistent_data_t;
@@ -45,11 +49,54 @@ void gui_sensmon_data_init(void) {
         persistent_sensor_data[i].last_known_value = LV_CHART_POINT_NONE;
         for (int j = 0; j < SENSOR_MONITOR_MAX_POINTS; j++) {
             persistent_sensor_data[i].values[j] = LV_CHART_POINT_NONE;
+            for (int lane = 0; lane < FUSION_MAX_SOURCES; lane++) {
+                persistent_sensor_data[i].source_values[lane][j] = LV_CHART_POINT_NONE;
+            }
         }
     }
     lv_memset(sensor_ui_elements, 0, sizeof(sensor_ui_elements));
 }
 
+static const lv_palette_t source_series_palettes[FUSION_MAX_SOURCES] = {LV_PALETTE_ORANGE, LV_PALETTE_GREEN};
+
+static uint8_t chart_source_count(sensor_data_type_t type) {
+    const fusion_config_t* config = fusion_get_config(type);
+    return (config->source_count > 1) ? config->source_count : 0;
+}
+
+static void push_point(int32_t* values, uint8_t* count, int32_t value) {
+    if (*count < SENSOR_MONITOR_MAX_POINTS) {
+        values[(*count)++] = value;
+    } else {
+        for (int i = 0; i < SENSOR_MONITOR_MAX_POINTS - 1; i++) {
+            values[i] = values[i + 1];
+        }
+        values[SENSOR_MONITOR_MAX_POINTS - 1] = value;
+    }
+}
+
+static void extend_range(const int32_t* values, uint8_t count, int32_t* min_y, int32_t* max_y) {
+    for (int i = 0; i < count; i++) {
+        if (values[i] != LV_CHART_POINT_NONE) {
+            if (values[i] < *min_y) *min_y = values[i];
+            if (values[i] > *max_y) *max_y = values[i];
+        }
+    }
+}
+
+/**
+ * @brief Fits chart range to fused and per-source points
+ */
+static void update_chart_range(sensor_data_type_t type) {
+    sensor_persistent_data_t* p_data = &persistent_sensor_data[type];
+    int32_t min_y = LV_COORD_MAX, max_y = LV_COORD_MIN;
+    extend_range(p_data->values, p_data->data_point_count, &min_y, &max_y);
+    for (uint8_t lane = 0; lane < chart_source_count(type); lane++) {
+        extend_range(p_data->source_values[lane], p_data->source_point_count[lane], &min_y, &max_y);
+    }
+    lv_chart_set_range(sensor_ui_elements[type].chart, LV_CHART_AXIS_PRIMARY_Y, (lv_coord_t)min_y, (lv_coord_t)max_y);
+}
+
 static void refresh_displayed_chart_layouts() {
     if (!ui_is_built || created_charts_count == 0 || !sensmon_screen_main_container) return;
     if (lv_obj_has_flag(sensmon_screen_main_container, LV_OBJ_FLAG_HIDDEN)) return;
@@ -149,6 +196,13 @@ static void ensure_chart_ui_created(sensor_data_type_t type) {
     lv_obj_set_style_margin_top(sc_ui->label_curr_value, 5, 0);
     lv_label_set_text(sc_ui->label_curr_value, "--");
 
+    for (uint8_t lane = 0; lane < chart_source_count(type); lane++) {
+        lv_obj_t* label_source = lv_label_create(sc_ui->label_container);
+        lv_obj_set_style_text_font(label_source, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_text_color(label_source, lv_palette_main(source_series_palettes[lane]), 0);
+        lv_label_set_text(label_source, fusion_source_name(fusion_get_config(type)->sources[lane]));
+    }
+
     sc_ui->chart = lv_chart_create(sc_ui->container);
     lv_obj_set_style_flex_grow(sc_ui->chart, 1, 0);
     lv_obj_set_height(sc_ui->chart, lv_pct(100));
@@ -158,6 +212,11 @@ static void ensure_chart_ui_created(sensor_data_type_t type) {
     lv_chart_set_div_line_count(sc_ui->chart, 3, SENSOR_MONITOR_MAX_POINTS);
     lv_obj_set_style_bg_color(sc_ui->chart, lv_color_hex(0xF0F0F0), 0);
 
+    /* Source series go first so that fused one is drawn on top of them */
+    for (uint8_t lane = 0; lane < chart_source_count(type); lane++) {
+        sc_ui->source_series[lane] = lv_chart_add_series(sc_ui->chart, lv_palette_lighten(source_series_palettes[lane], 1), LV_CHART_AXIS_PRIMARY_Y);
+        lv_chart_set_all_value(sc_ui->chart, sc_ui->source_series[lane], LV_CHART_POINT_NONE);
+    }
     sc_ui->series = lv_chart_add_series(sc_ui->chart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_PRIMARY_Y);
     lv_chart_set_all_value(sc_ui->chart, sc_ui->series, LV_CHART_POINT_NONE);
     lv_chart_refresh(sc_ui->chart);
@@ -214,15 +273,14 @@ static void refresh_all_chart_data_and_labels() {
         for (int i = 0; i < p_data->data_point_count; i++) {
             lv_chart_set_next_value(sc_ui->chart, sc_ui->series, p_data->values[i]);
         }
-
-        int32_t min_y = LV_COORD_MAX, max_y = LV_COORD_MIN;
-        for (int i = 0; i < p_data->data_point_count; ++i) {
-            if (p_data->values[i] != LV_CHART_POINT_NONE) {
-                if (p_data->values[i] < min_y) min_y = p_data->values[i];
-                if (p_data->values[i] > max_y) max_y = p_data->values[i];
+        for (uint8_t lane = 0; lane < chart_source_count(type); lane++) {
+            lv_chart_set_all_value(sc_ui->chart, sc_ui->source_series[lane], LV_CHART_POINT_NONE);
+            for (int i = 0; i < p_data->source_point_count[lane]; i++) {
+                lv_chart_set_next_value(sc_ui->chart, sc_ui->source_series[lane], p_data->source_values[lane][i]);
             }
         }
-        lv_chart_set_range(sc_ui->chart, LV_CHART_AXIS_PRIMARY_Y, (lv_coord_t)min_y, (lv_coord_t)max_y);
+
+        update_chart_range(type);
         lv_chart_refresh(sc_ui->chart);
     }
 
@@ -333,14 +391,7 @@ void gui_sensmon_push_chart_value(sensor_data_type_t type, int32_t value) {
         p_data->has_ever_received_data = true;
     }
 
-    if (p_data->data_point_count < SENSOR_MONITOR_MAX_POINTS) {
-        p_data->values[p_data->data_point_count++] = value;
-    } else {
-        for (int i = 0; i < SENSOR_MONITOR_MAX_POINTS - 1; i++) {
-            p_data->values[i] = p_data->values[i + 1];
-        }
-        p_data->values[SENSOR_MONITOR_MAX_POINTS - 1] = value;
-    }
+    push_point(p_data->values, &p_data->data_point_count, value);
 
     if (ui_is_built && sensmon_screen_main_container && !lv_obj_has_flag(sensmon_screen_main_container, LV_OBJ_FLAG_HIDDEN)) {
         if (p_data->has_ever_received_data) {
@@ -349,15 +400,7 @@ void gui_sensmon_push_chart_value(sensor_data_type_t type, int32_t value) {
             if (sensor_ui_elements[type].container) {
                 sensor_chart_ui_t* sc_ui = &sensor_ui_elements[type];
                 lv_chart_set_next_value(sc_ui->chart, sc_ui->series, value);
-
-                int32_t min_y = LV_COORD_MAX, max_y = LV_COORD_MIN;
-                for (int i = 0; i < p_data->data_point_count; i++) {
-                    if (p_data->values[i] != LV_CHART_POINT_NONE) {
-                        if (p_data->values[i] < min_y) min_y = p_data->values[i];
-                        if (p_data->values[i] > max_y) max_y = p_data->values[i];
-                    }
-                }
-                lv_chart_set_range(sc_ui->chart, LV_CHART_AXIS_PRIMARY_Y, (lv_coord_t)min_y, (lv_coord_t)max_y);
+                update_chart_range(type);
                 if (was_first_data && p_data->has_ever_received_data) {
                     refresh_displayed_chart_layouts();
                 }
@@ -365,3 +408,20 @@ void gui_sensmon_push_chart_value(sensor_data_type_t type, int32_t value) {
         }
     }
 }
+
+void gui_sensmon_push_source_chart_value(sensor_data_type_t type, uint8_t lane, int32_t value) {
+    if (type >= SENSOR_TYPE_COUNT || lane >= chart_source_count(type)) {
+        return;
+    }
+
+    sensor_persistent_data_t* p_data = &persistent_sensor_data[type];
+    push_point(p_data->source_values[lane], &p_data->source_point_count[lane], value);
+
+    if (ui_is_built && sensmon_screen_main_container && !lv_obj_has_flag(sensmon_screen_main_container, LV_OBJ_FLAG_HIDDEN)) {
+        sensor_chart_ui_t* sc_ui = &sensor_ui_elements[type];
+        if (sc_ui->container) {
+            lv_chart_set_next_value(sc_ui->chart, sc_ui->source_series[lane], value);
+            update_chart_range(type);
+        }
+    }
+}
@@ -20,6 +20,7 @@
 
 #define HISTORY_MAX_DATE_OPTIONS 7
 #define HISTORY_CHART_POINTS 6
+#define HISTORY_PEAK_PERIOD_S (7 * 86400)
 
 typedef enum {
     GUI_SCREEN_SENSORS,
@@ -27,7 +28,18 @@ typedef enum {
     GUI_SCREEN_COUNT,
 } gui_screen_id_t;
 
-typedef void (*history_data_fetcher_t)(sensor_data_type_t, uint32_t, int32_t*, uint16_t);
+/**
+ * @brief Stored readings source for history screen
+ * @note Functions fill caller-owned values buffer and return number of loaded values,
+ *       remaining ones are set to LV_CHART_POINT_NONE. next/prev keep buffer untouched and
+ *       return 0 when there is no newer/older data than the current window.
+ */
+typedef struct {
+    uint16_t (*seek)(sensor_data_type_t type, uint32_t timestamp, int32_t* values, uint16_t count);
+    uint16_t (*next)(sensor_data_type_t type, int32_t* values, uint16_t count);
+    uint16_t (*prev)(sensor_data_type_t type, int32_t* values, uint16_t count);
+    bool (*peak)(sensor_data_type_t type, uint32_t from_ts, uint32_t to_ts, int32_t* value, uint32_t* timestamp);
+} history_data_source_t;
 
 void gui_init(void);
 void gui_process(void);
@@ -44,8 +56,9 @@ bool gui_sensmon_screen_is_built(void);
 void gui_sensmon_screen_set_visibility(bool visible);
 void gui_sensmon_update_current_value(sensor_data_type_t type, int32_t value);
 void gui_sensmon_push_chart_value(sensor_data_type_t type, int32_t value);
+void gui_sensmon_push_source_chart_value(sensor_data_type_t type, uint8_t lane, int32_t value);
 
 void gui_history_screen_create(lv_obj_t* parent);
 void gui_history_screen_destroy(void);
 bool gui_history_screen_is_active(void);
-void gui_history_init_data_fetcher(history_data_fetcher_t);
+void gui_history_init_data_source(const history_data_source_t* data_source);
@@ -7,13 +7,13 @@
 
 #include "indev.h"
 #include "slog.h"
-#include "i2c.h"
+#include "i2c_bus.h"
 #include "main.h"
 #include "cmsis_os2.h"
 
 #include <stdbool.h>
 
-#define FT6336U_ADDR (0x38 << 1)
+#define FT6336U_ADDR 0x38
 #define FT6336U_REG_TD_STATUS 0x02
 #define FT6336U_REG_P1_XH     0x03
 
@@ -54,11 +54,15 @@ static void ft6336u_read_touch(void) {
     touch_pending = false;
 
     uint8_t points;
-    HAL_I2C_Mem_Read(&touch_i2c, FT6336U_ADDR, FT6336U_REG_TD_STATUS, 1, &points, 1, HAL_MAX_DELAY);
+    if (i2c_bus_mem_read(I2C_BUS_TOUCH, I2C_PRIORITY_HIGH, FT6336U_ADDR, FT6336U_REG_TD_STATUS, &points, 1) != I2C_STATUS_OK) {
+        return;
+    }
     points &= 0x0F;
     if (points > 0) {
         uint8_t data[4];
-        HAL_I2C_Mem_Read(&touch_i2c, FT6336U_ADDR, FT6336U_REG_P1_XH, 1, data, 4, HAL_MAX_DELAY);
+        if (i2c_bus_mem_read(I2C_BUS_TOUCH, I2C_PRIORITY_HIGH, FT6336U_ADDR, FT6336U_REG_P1_XH, data, 4) != I2C_STATUS_OK) {
+            return;
+        }
         indev.touch.touched = true;
         indev.touch.x = 480 - (((data[2] & 0x0F) << 8) | data[3]);
         indev.touch.y = ((data[0] & 0x0F) << 8) | data[1];
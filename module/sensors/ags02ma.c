@@ -7,58 +7,60 @@
 
 #include "sensors.h"
 #include "slog.h"
-#include "i2c.h"
+#include "i2c_bus.h"
 #include "cmsis_os2.h"
 
-#define AGS02MA_ADDR (0x1A << 1)
+#define AGS02MA_BUS I2C_BUS_SENSORS
+#define AGS02MA_ADDR 0x1A
 #define AGS02MA_CMD_GET_READING 0x00
+#define AGS02MA_STATUS_RDY 0x01  /**< Set while conversion or warm-up is in progress */
+#define AGS02MA_CONVERSION_TIME_MS 100
 
-/**
- * @brief CRC8 calculation for received data
- *
- * @param data received data buffer
- * @param size size of data
- * @return uint8_t crc
- */
-static uint8_t calc_crc8(const uint8_t* data, uint8_t size) {
-    uint8_t crc = 0xFF;
-    for (uint8_t i = 0; i < size; i++) {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ 0x31;
-            } else {
-                crc <<= 1;
-            }
-        }
-    }
-    return crc;
-}
-
-void ags02ma_process_reading(sensor_reading_handler_t reading_handler) {
-    uint8_t rx_buffer[5];
+static bool ags02ma_start_conversion(void) {
     uint8_t cmd = AGS02MA_CMD_GET_READING;
 
-    if (HAL_I2C_Master_Transmit(&sens_i2c, AGS02MA_ADDR, &cmd, 1, HAL_MAX_DELAY) != HAL_OK) {
+    if (i2c_bus_transmit(AGS02MA_BUS, I2C_PRIORITY_NORMAL, AGS02MA_ADDR, &cmd, 1) != I2C_STATUS_OK) {
         SLOG_ERROR("AGS02MA data request failed");
-        return;
+        return false;
     }
+    return true;
+}
 
-    osDelay(100);
+static sensor_fetch_status_t ags02ma_fetch_result(sensor_reading_handler_t reading_handler) {
+    uint8_t rx_buffer[5];
 
-    if (HAL_I2C_Master_Receive(&sens_i2c, AGS02MA_ADDR, rx_buffer, 5, HAL_MAX_DELAY) != HAL_OK) {
+    if (i2c_bus_receive(AGS02MA_BUS, I2C_PRIORITY_NORMAL, AGS02MA_ADDR, rx_buffer, 5) != I2C_STATUS_OK) {
         SLOG_ERROR("AGS02MA data receive failed");
-        return;
+        return SENSOR_FETCH_ERROR;
     }
 
-    if (calc_crc8(rx_buffer, 4) != rx_buffer[4]) {
+    if (sensor_crc8(rx_buffer, 4) != rx_buffer[4]) {
         SLOG_ERROR("AGS02MA data receive failed, CRC8 mismatch");
-        return;
+        return SENSOR_FETCH_CRC_ERROR;
+    }
+    if (rx_buffer[0] & AGS02MA_STATUS_RDY) {
+        return SENSOR_FETCH_NOT_READY;
     }
 
     uint32_t tvoc = (rx_buffer[1] << 16) | (rx_buffer[2] << 8) | rx_buffer[3];
     SLOG_DEBUG("AGS02MA: TVOC = %lu ppb", tvoc);
     if (reading_handler) {
-        (*reading_handler)(SENSOR_TVOC, (int32_t)tvoc);
+        (*reading_handler)(SENSOR_TVOC, SENSOR_SOURCE_AGS02MA, (int32_t)tvoc);
     }
+    return SENSOR_FETCH_OK;
 }
+
+SENSOR_DRIVER_REGISTER(ags02ma) = {
+    .name = "AGS02MA",
+    .bus = AGS02MA_BUS,
+    .addr = AGS02MA_ADDR,
+    .source = SENSOR_SOURCE_AGS02MA,
+    .channel_count = 1,
+    .channels = {{SENSOR_TVOC, "ppb", 1}},
+    .conversion_time_ms = AGS02MA_CONVERSION_TIME_MS,
+    .ready_polling = true,
+    .period_ms = 30000,
+    .phase_ms = 400,
+    .start_conversion = ags02ma_start_conversion,
+    .fetch_result = ags02ma_fetch_result,
+};
@@ -7,58 +7,40 @@
 
 #include "sensors.h"
 #include "slog.h"
-#include "i2c.h"
+#include "i2c_bus.h"
 #include "cmsis_os2.h"
 
-#define AHT20_ADDR (0x38 << 1)
+#define AHT20_BUS I2C_BUS_SENSORS
+#define AHT20_ADDR 0x38
 #define AGS02MA_CMD_GET_READING 0xAC
+#define AHT20_STATUS_BUSY 0x80
+#define AHT20_CONVERSION_TIME_MS 80
 
-/**
- * @brief CRC8 calculation for received data
- *
- * @param data received data buffer
- * @param size size of data
- * @return uint8_t crc
- */
-static uint8_t calc_crc8(const uint8_t* data, uint8_t size) {
-    uint8_t crc = 0xFF;
-    for (uint8_t i = 0; i < size; i++) {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ 0x31;
-            } else {
-                crc <<= 1;
-            }
-        }
-    }
-    return crc;
-}
-
-void aht20_process_reading(sensor_reading_handler_t reading_handler) {
-    uint8_t rx_buffer[7];
+static bool aht20_start_conversion(void) {
     uint8_t cmd[3] = {AGS02MA_CMD_GET_READING, 0x33, 0x00};
 
-    if (HAL_I2C_Master_Transmit(&sens_i2c, AHT20_ADDR, cmd, 3, HAL_MAX_DELAY) != HAL_OK) {
+    if (i2c_bus_transmit(AHT20_BUS, I2C_PRIORITY_NORMAL, AHT20_ADDR, cmd, 3) != I2C_STATUS_OK) {
         SLOG_ERROR("AHT20 data request failed");
-        return;
+        return false;
     }
+    return true;
+}
 
-    osDelay(100);
+static sensor_fetch_status_t aht20_fetch_result(sensor_reading_handler_t reading_handler) {
+    uint8_t rx_buffer[7];
 
-    if (HAL_I2C_Master_Receive(&sens_i2c, AHT20_ADDR, rx_buffer, 7, HAL_MAX_DELAY) != HAL_OK) {
+    if (i2c_bus_receive(AHT20_BUS, I2C_PRIORITY_NORMAL, AHT20_ADDR, rx_buffer, 7) != I2C_STATUS_OK) {
         SLOG_ERROR("AHT20 data receive failed");
-        return;
+        return SENSOR_FETCH_ERROR;
     }
 
-    if (calc_crc8(rx_buffer, 6) != rx_buffer[6]) {
-        SLOG_ERROR("AGS02MA data receive failed, CRC8 mismatch");
-        return;
+    if ((rx_buffer[0] & AHT20_STATUS_BUSY) != 0) {
+        return SENSOR_FETCH_NOT_READY;
     }
 
-    if ((rx_buffer[0] & 0x80) != 0) {
-        SLOG_WARN("AHT20 not ready");
-        return;
+    if (sensor_crc8(rx_buffer, 6) != rx_buffer[6]) {
+        SLOG_ERROR("AHT20 data receive failed, CRC8 mismatch");
+        return SENSOR_FETCH_CRC_ERROR;
     }
 
     uint32_t raw_hum = ((uint32_t)(rx_buffer[1]) << 12) | ((uint32_t)(rx_buffer[2]) << 4) | (rx_buffer[3] >> 4);
@@ -69,7 +51,23 @@ void aht20_process_reading(sensor_reading_handler_t reading_handler) {
     SLOG_DEBUG("AHT20: Temperature = %d.%02d °C, Humidity = %u.%02u %%", temperature / 100, temperature % 100, humidity / 100, humidity % 100);
 
     if (reading_handler) {
-        (*reading_handler)(SENSOR_TEMPERATURE, (int32_t)temperature);
-        (*reading_handler)(SENSOR_HUMIDITY, (int32_t)humidity);
+        (*reading_handler)(SENSOR_TEMPERATURE, SENSOR_SOURCE_AHT20, (int32_t)temperature);
+        (*reading_handler)(SENSOR_HUMIDITY, SENSOR_SOURCE_AHT20, (int32_t)humidity);
     }
+    return SENSOR_FETCH_OK;
 }
+
+SENSOR_DRIVER_REGISTER(aht20) = {
+    .name = "AHT20",
+    .bus = AHT20_BUS,
+    .addr = AHT20_ADDR,
+    .source = SENSOR_SOURCE_AHT20,
+    .channel_count = 2,
+    .channels = {{SENSOR_TEMPERATURE, "degC", 100}, {SENSOR_HUMIDITY, "%RH", 100}},
+    .conversion_time_ms = AHT20_CONVERSION_TIME_MS,
+    .ready_polling = true,
+    .period_ms = 5000,
+    .phase_ms = 200,
+    .start_conversion = aht20_start_conversion,
+    .fetch_result = aht20_fetch_result,
+};
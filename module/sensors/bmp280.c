@@ -7,16 +7,38 @@
 
 #include "sensors.h"
 #include "slog.h"
-#include "i2c.h"
+#include "i2c_bus.h"
 #include "cmsis_os2.h"
 
-#define BMP280_ADDR            (0x77 << 1)
+#define BMP280_BUS             I2C_BUS_SENSORS
+#define BMP280_ADDR            0x77
 #define BMP280_REG_ID          0xD0
+#define BMP280_REG_RESET       0xE0
 #define BMP280_REG_CALIB_START 0x88
 #define BMP280_REG_CTRL_MEAS   0xF4
+#define BMP280_REG_CONFIG      0xF5
 #define BMP280_REG_PRESS_MSB   0xF7
 #define BMP280_REG_TEMP_MSB    0xFA
 
+#define BMP280_CHIP_ID         0x58
+#define BMP280_RESET_VALUE     0xB6
+#define BMP280_MODE_NORMAL     0x03
+#define BMP280_RESET_TIME_MS   2
+
+/* Sampling settings register values, see datasheet chapter 3.3 - 3.6 */
+#ifndef BMP280_OSRS_T
+#define BMP280_OSRS_T          2   /**< Temperature oversampling x2 */
+#endif
+#ifndef BMP280_OSRS_P
+#define BMP280_OSRS_P          5   /**< Pressure oversampling x16 */
+#endif
+#ifndef BMP280_FILTER
+#define BMP280_FILTER          4   /**< IIR filter coefficient 16 */
+#endif
+#ifndef BMP280_T_SB
+#define BMP280_T_SB            1   /**< Standby 62.5 ms, ~9 Hz output data rate with settings above */
+#endif
+
 typedef struct {
     uint16_t dig_T1;
     int16_t  dig_T2;
@@ -35,15 +57,15 @@ typedef struct {
 static bmp280_calib_data calib;
 static int32_t t_fine = 0;
 
-static HAL_StatusTypeDef bmp280_read_bytes(uint8_t reg, uint8_t* buf, uint16_t len) {
-    return HAL_I2C_Mem_Read(&sens_i2c, BMP280_ADDR, reg, 1, buf, len, HAL_MAX_DELAY);
+static bool bmp280_read_bytes(uint8_t reg, uint8_t* buf, uint16_t len) {
+    return i2c_bus_mem_read(BMP280_BUS, I2C_PRIORITY_NORMAL, BMP280_ADDR, reg, buf, len) == I2C_STATUS_OK;
 }
 
-static void bmp280_read_calibration(void) {
+static bool bmp280_read_calibration(void) {
     uint8_t calib_data[24];
-    if (bmp280_read_bytes(BMP280_REG_CALIB_START, calib_data, 24) != HAL_OK) {
+    if (!bmp280_read_bytes(BMP280_REG_CALIB_START, calib_data, 24)) {
         SLOG_ERROR("BMP280 failed to read calibration data");
-        return;
+        return false;
     }
 
     calib.dig_T1 = (calib_data[1] << 8) | calib_data[0];
@@ -58,6 +80,46 @@ static void bmp280_read_calibration(void) {
     calib.dig_P7 = (int16_t)((calib_data[19] << 8) | calib_data[18]);
     calib.dig_P8 = (int16_t)((calib_data[21] << 8) | calib_data[20]);
     calib.dig_P9 = (int16_t)((calib_data[23] << 8) | calib_data[22]);
+    return true;
+}
+
+static bool bmp280_write_reg(uint8_t reg, uint8_t value) {
+    return i2c_bus_mem_write(BMP280_BUS, I2C_PRIORITY_NORMAL, BMP280_ADDR, reg, &value, 1) == I2C_STATUS_OK;
+}
+
+/**
+ * @brief Resets sensor, caches calibration and starts continuous measurements
+ */
+static bool bmp280_init(void) {
+    uint8_t id = 0;
+    if (!bmp280_read_bytes(BMP280_REG_ID, &id, 1)) {
+        SLOG_ERROR("BMP280 ID read failed");
+        return false;
+    }
+    if (id != BMP280_CHIP_ID) {
+        SLOG_ERROR("BMP280 wrong ID: 0x%02X", id);
+        return false;
+    }
+
+    /* Config register is only guaranteed to be written in sleep mode, which is the state after reset */
+    if (!bmp280_write_reg(BMP280_REG_RESET, BMP280_RESET_VALUE)) {
+        SLOG_ERROR("BMP280 reset failed");
+        return false;
+    }
+    osDelay(BMP280_RESET_TIME_MS);
+
+    if (!bmp280_read_calibration()) {
+        return false;
+    }
+
+    uint8_t config = (BMP280_T_SB << 5) | (BMP280_FILTER << 2);
+    uint8_t ctrl_meas = (BMP280_OSRS_T << 5) | (BMP280_OSRS_P << 2) | BMP280_MODE_NORMAL;
+    if (!bmp280_write_reg(BMP280_REG_CONFIG, config) || !bmp280_write_reg(BMP280_REG_CTRL_MEAS, ctrl_meas)) {
+        SLOG_ERROR("BMP280 configuration failed");
+        return false;
+    }
+    SLOG_DEBUG("BMP280 normal mode, config 0x%02X ctrl_meas 0x%02X", config, ctrl_meas);
+    return true;
 }
 
 static int32_t bmp280_compensate_temperature(int32_t adc_t) {
@@ -90,24 +152,16 @@ static uint32_t bmp280_compensate_pressure(int32_t adc_p) {
     return (uint32_t)(p >> 8);
 }
 
-void bmp280_process_reading(sensor_reading_handler_t reading_handler) {
-    uint8_t id;
-    if (bmp280_read_bytes(BMP280_REG_ID, &id, 1) != HAL_OK || id != 0x58) {
-        SLOG_ERROR("BMP280 not found or wrong ID: 0x%02X", id);
-        return;
-    }
-
-    bmp280_read_calibration();
-
-    uint8_t ctrl_meas = 0x27;
-    HAL_I2C_Mem_Write(&sens_i2c, BMP280_ADDR, BMP280_REG_CTRL_MEAS, 1, &ctrl_meas, 1, HAL_MAX_DELAY);
-
-    osDelay(100);
+static bool bmp280_start_conversion(void) {
+    /* Sensor measures continuously in normal mode, latest result is always available */
+    return true;
+}
 
+static sensor_fetch_status_t bmp280_fetch_result(sensor_reading_handler_t reading_handler) {
     uint8_t data[6];
-    if (bmp280_read_bytes(BMP280_REG_PRESS_MSB, data, 6) != HAL_OK) {
+    if (!bmp280_read_bytes(BMP280_REG_PRESS_MSB, data, 6)) {
         SLOG_ERROR("BMP280 read failed");
-        return;
+        return SENSOR_FETCH_ERROR;
     }
 
     int32_t adc_t = (int32_t)(((uint32_t)data[3] << 12) | ((uint32_t)data[4] << 4) | (data[5] >> 4));
@@ -118,7 +172,25 @@ void bmp280_process_reading(sensor_reading_handler_t reading_handler) {
     SLOG_DEBUG("BMP280: Temperature = %d.%02d °C, Pressure = %lu hPa", temperature / 100, temperature % 100, pressure / 100);
 
     if (reading_handler) {
-        (*reading_handler)(SENSOR_TEMPERATURE, (int32_t)temperature);
-        (*reading_handler)(SENSOR_PRESSURE, (int32_t)pressure);
+        (*reading_handler)(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, (int32_t)temperature);
+        (*reading_handler)(SENSOR_PRESSURE, SENSOR_SOURCE_BMP280, (int32_t)pressure);
     }
-}
\ No newline at end of file
+    return SENSOR_FETCH_OK;
+}
+
+SENSOR_DRIVER_REGISTER(bmp280) = {
+    .name = "BMP280",
+    .bus = BMP280_BUS,
+    .addr = BMP280_ADDR,
+    .source = SENSOR_SOURCE_BMP280,
+    .channel_count = 2,
+    .channels = {{SENSOR_TEMPERATURE, "degC", 100}, {SENSOR_PRESSURE, "Pa", 1}},
+    .conversion_time_ms = 0,
+    .ready_polling = false,
+    .period_ms = 1000,
+    .phase_ms = 0,
+    .burst_period_ms = 100,   /**< Output data rate is ~9 Hz with standby and oversampling settings above */
+    .init = bmp280_init,
+    .start_conversion = bmp280_start_conversion,
+    .fetch_result = bmp280_fetch_result,
+};
@@ -0,0 +1,147 @@
+/**
+ * @file filter.c
+ * @brief Fixed-point per-channel filter chain: median spike rejection, EMA and 1-D Kalman
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "filter.h"
+#include "monotime.h"
+#include "slog.h"
+
+#define FILTER_BENCHMARK_INPUTS  64     /**< Shall be power of two */
+#define FILTER_BENCHMARK_SAMPLES 1000
+#define FILTER_BENCHMARK_RUNS    4
+
+static const filter_config_t filter_configs[SENSOR_TYPE_COUNT] = {
+    [SENSOR_TEMPERATURE] = {.median_n = 3, .ema_alpha = FILTER_ONE / 4},
+    [SENSOR_HUMIDITY] = {.median_n = 3, .ema_alpha = FILTER_ONE / 4},
+    /* BMP280 output is already oversampled and IIR filtered, residual noise is about 2 Pa */
+    [SENSOR_PRESSURE] = {.kalman = true, .kalman_q = 1, .kalman_r = 4},
+    /* Sparse samples with occasional spikes on gas puffs */
+    [SENSOR_TVOC] = {.median_n = 5, .ema_alpha = FILTER_ONE / 2},
+};
+
+const filter_config_t* filter_get_config(sensor_data_type_t type) {
+    return &filter_configs[type];
+}
+
+void filter_reset(filter_state_t* state) {
+    state->primed = false;
+    state->window_pos = 0;
+    state->window_fill = 0;
+}
+
+/**
+ * @brief Multiplies fixed-point value by coefficient without 64-bit overflow
+ *
+ * @param coef coefficient in FILTER_ONE units, not greater than FILTER_ONE
+ */
+static int64_t fixed_mul(int64_t value, uint32_t coef) {
+    int64_t whole = value >> FILTER_FRAC_BITS;
+    int64_t frac = value & (FILTER_ONE - 1);
+    return whole * coef + ((frac * coef) >> FILTER_FRAC_BITS);
+}
+
+static int32_t fixed_round(int64_t value) {
+    return (int32_t)((value + FILTER_ONE / 2) >> FILTER_FRAC_BITS);
+}
+
+static int32_t median_stage(filter_state_t* state, uint8_t median_n, int32_t value) {
+    if (median_n > FILTER_MEDIAN_MAX) {
+        median_n = FILTER_MEDIAN_MAX;
+    }
+    state->window[state->window_pos] = value;
+    state->window_pos = (state->window_pos + 1) % median_n;
+    if (state->window_fill < median_n) {
+        state->window_fill++;
+    }
+
+    /* Window is at most FILTER_MEDIAN_MAX long, insertion sort keeps cost bounded */
+    int32_t sorted[FILTER_MEDIAN_MAX];
+    for (uint8_t i = 0; i < state->window_fill; i++) {
+        int32_t item = state->window[i];
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > item; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = item;
+    }
+    return sorted[state->window_fill / 2];
+}
+
+static int32_t ema_stage(filter_state_t* state, uint32_t alpha, int32_t value) {
+    int64_t target = (int64_t)value << FILTER_FRAC_BITS;
+    state->ema += fixed_mul(target - state->ema, alpha);
+    return fixed_round(state->ema);
+}
+
+static int32_t kalman_stage(filter_state_t* state, const filter_config_t* config, int32_t value) {
+    uint32_t p = state->kalman_p + config->kalman_q;
+    if (p < state->kalman_p) {
+        p = UINT32_MAX;
+    }
+    uint64_t denominator = (uint64_t)p + config->kalman_r;
+    uint32_t gain = (denominator > 0) ? (uint32_t)(((uint64_t)p << FILTER_FRAC_BITS) / denominator) : FILTER_ONE;
+
+    int64_t measurement = (int64_t)value << FILTER_FRAC_BITS;
+    state->kalman_x += fixed_mul(measurement - state->kalman_x, gain);
+    state->kalman_p = p - (uint32_t)(((uint64_t)p * gain) >> FILTER_FRAC_BITS);
+    return fixed_round(state->kalman_x);
+}
+
+int32_t filter_apply(filter_state_t* state, const filter_config_t* config, int32_t value) {
+    if (!state->primed) {
+        state->primed = true;
+        state->ema = (int64_t)value << FILTER_FRAC_BITS;
+        state->kalman_x = (int64_t)value << FILTER_FRAC_BITS;
+        state->kalman_p = config->kalman_r;
+    }
+    if (config->median_n > 1) {
+        value = median_stage(state, config->median_n, value);
+    }
+    if (config->ema_alpha > 0) {
+        value = ema_stage(state, config->ema_alpha, value);
+    }
+    if (config->kalman) {
+        value = kalman_stage(state, config, value);
+    }
+    return value;
+}
+
+uint32_t filter_measure_cycles(sensor_data_type_t type, uint32_t samples) {
+    const filter_config_t* config = filter_get_config(type);
+    int32_t inputs[FILTER_BENCHMARK_INPUTS];
+    uint32_t noise = 1;
+    for (uint32_t i = 0; i < FILTER_BENCHMARK_INPUTS; i++) {
+        noise = noise * 1664525 + 1013904223;
+        inputs[i] = 10000 + (int32_t)(noise >> 24) - 128 + ((i % 16 == 0) ? 5000 : 0);
+    }
+    if (samples == 0) {
+        return 0;
+    }
+
+    filter_state_t state;
+    filter_reset(&state);
+    volatile int32_t sink;
+    uint32_t start = monotime_cycles();
+    for (uint32_t i = 0; i < samples; i++) {
+        sink = filter_apply(&state, config, inputs[i & (FILTER_BENCHMARK_INPUTS - 1)]);
+    }
+    uint32_t elapsed = monotime_cycles() - start;
+    (void)sink;
+    return elapsed / samples;
+}
+
+void filter_benchmark_report(void) {
+    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        uint32_t best = UINT32_MAX;
+        for (uint8_t run = 0; run < FILTER_BENCHMARK_RUNS; run++) {
+            uint32_t cycles = filter_measure_cycles(type, FILTER_BENCHMARK_SAMPLES);
+            if (cycles < best) {
+                best = cycles;
+            }
+        }
+        SLOG_INFO("filter type %u: %lu cycles per sample", type, best);
+    }
+}
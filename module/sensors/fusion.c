@@ -0,0 +1,62 @@
+/**
+ * @file fusion.c
+ * @brief Combining values of one quantity measured by several sources
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "fusion.h"
+#include <stddef.h>
+
+static const fusion_config_t fusion_configs[SENSOR_TYPE_COUNT] = {
+    /* AHT20 temperature accuracy is ±0.3 °C against ±1 °C of BMP280, which is kept as a weaker contributor */
+    [SENSOR_TEMPERATURE] = {FUSION_WEIGHTED_MEAN, 2, {SENSOR_SOURCE_AHT20, SENSOR_SOURCE_BMP280}, {3, 1}},
+    [SENSOR_HUMIDITY] = {FUSION_PRIMARY_FALLBACK, 1, {SENSOR_SOURCE_AHT20}, {1}},
+    [SENSOR_PRESSURE] = {FUSION_PRIMARY_FALLBACK, 1, {SENSOR_SOURCE_BMP280}, {1}},
+    [SENSOR_TVOC] = {FUSION_PRIMARY_FALLBACK, 1, {SENSOR_SOURCE_AGS02MA}, {1}},
+};
+
+static const char* const source_names[SENSOR_SOURCE_COUNT] = {
+    [SENSOR_SOURCE_AHT20] = "AHT20",
+    [SENSOR_SOURCE_BMP280] = "BMP280",
+    [SENSOR_SOURCE_AGS02MA] = "AGS02MA",
+};
+
+const fusion_config_t* fusion_get_config(sensor_data_type_t type) {
+    return &fusion_configs[type];
+}
+
+int8_t fusion_source_lane(sensor_data_type_t type, sensor_source_t source) {
+    const fusion_config_t* config = &fusion_configs[type];
+    for (uint8_t lane = 0; lane < config->source_count; lane++) {
+        if (config->sources[lane] == source) {
+            return (int8_t)lane;
+        }
+    }
+    return -1;
+}
+
+int32_t fusion_apply(sensor_data_type_t type, const int32_t lanes[FUSION_MAX_SOURCES]) {
+    const fusion_config_t* config = &fusion_configs[type];
+    int64_t weighted_sum = 0;
+    uint32_t weight_total = 0;
+
+    for (uint8_t lane = 0; lane < config->source_count; lane++) {
+        if (lanes[lane] == FUSION_NO_VALUE) {
+            continue;
+        }
+        if (config->mode == FUSION_PRIMARY_FALLBACK) {
+            return lanes[lane];
+        }
+        weighted_sum += (int64_t)lanes[lane] * config->weights[lane];
+        weight_total += config->weights[lane];
+    }
+    if (weight_total == 0) {
+        return FUSION_NO_VALUE;
+    }
+    return (int32_t)(weighted_sum / weight_total);
+}
+
+const char* fusion_source_name(sensor_source_t source) {
+    return (source < SENSOR_SOURCE_COUNT) ? source_names[source] : NULL;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file filter.h
+ * @brief Fixed-point per-channel filter chain: median spike rejection, EMA and 1-D Kalman
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FILTER_MEDIAN_MAX 5
+#define FILTER_FRAC_BITS  16   /**< Fractional bits of filter state and coefficients */
+#define FILTER_ONE        (1UL << FILTER_FRAC_BITS)
+
+/**
+ * @brief Filter chain of one quantity, stages run in order median -> EMA -> Kalman
+ */
+typedef struct {
+    uint8_t median_n;   /**< Odd median window length, 0 or 1 disables the stage */
+    uint32_t ema_alpha; /**< Weight of a new sample in FILTER_ONE units, 0 disables the stage */
+    bool kalman;
+    uint32_t kalman_q;  /**< Process noise variance, value units squared */
+    uint32_t kalman_r;  /**< Measurement noise variance, value units squared */
+} filter_config_t;
+
+/**
+ * @brief Filter state of one channel
+ */
+typedef struct {
+    bool primed;
+    uint8_t window_pos;
+    uint8_t window_fill;
+    int32_t window[FILTER_MEDIAN_MAX];
+    int64_t ema;        /**< Fixed-point with FILTER_FRAC_BITS */
+    int64_t kalman_x;   /**< Fixed-point with FILTER_FRAC_BITS */
+    uint32_t kalman_p;  /**< Estimate variance, value units squared */
+} filter_state_t;
+
+/**
+ * @brief Returns filter chain configuration of quantity
+ */
+const filter_config_t* filter_get_config(sensor_data_type_t type);
+
+/**
+ * @brief Forgets history of channel, next sample passes through unchanged
+ */
+void filter_reset(filter_state_t* state);
+
+/**
+ * @brief Runs one sample through filter chain, takes constant time per sample
+ *
+ * @return filtered value
+ */
+int32_t filter_apply(filter_state_t* state, const filter_config_t* config, int32_t value);
+
+/**
+ * @brief Measures filter chain of quantity on synthetic input with spikes
+ *
+ * @return average monotime_cycles() ticks per sample, CPU cycles on target
+ */
+uint32_t filter_measure_cycles(sensor_data_type_t type, uint32_t samples);
+
+/**
+ * @brief Logs cost of every configured filter chain, the best of several runs is taken to skip preemptions
+ */
+void filter_benchmark_report(void);
@@ -0,0 +1,54 @@
+/**
+ * @file fusion.h
+ * @brief Combining values of one quantity measured by several sources
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include <stdint.h>
+
+#define FUSION_MAX_SOURCES 2
+#define FUSION_NO_VALUE    INT32_MIN
+
+typedef enum {
+    FUSION_WEIGHTED_MEAN,    /**< Mean of available sources by their weights */
+    FUSION_PRIMARY_FALLBACK, /**< First available source in configured order */
+} fusion_mode_t;
+
+/**
+ * @brief Sources of one quantity, source position is its lane in per-source arrays
+ */
+typedef struct {
+    fusion_mode_t mode;
+    uint8_t source_count;
+    sensor_source_t sources[FUSION_MAX_SOURCES];
+    uint8_t weights[FUSION_MAX_SOURCES]; /**< Used by FUSION_WEIGHTED_MEAN only */
+} fusion_config_t;
+
+/**
+ * @brief Returns sources configuration of quantity
+ */
+const fusion_config_t* fusion_get_config(sensor_data_type_t type);
+
+/**
+ * @brief Returns lane of source within quantity
+ *
+ * @return lane index, -1 if source does not provide quantity
+ */
+int8_t fusion_source_lane(sensor_data_type_t type, sensor_source_t source);
+
+/**
+ * @brief Produces logical value of quantity from per-source values
+ *
+ * @param lanes per-source values, FUSION_NO_VALUE for missing ones
+ * @return fused value, FUSION_NO_VALUE if no source has a value
+ */
+int32_t fusion_apply(sensor_data_type_t type, const int32_t lanes[FUSION_MAX_SOURCES]);
+
+/**
+ * @brief Returns short name of source
+ */
+const char* fusion_source_name(sensor_source_t source);
@@ -0,0 +1,46 @@
+/**
+ * @file latest.h
+ * @brief Latest value of every (quantity, source) channel, readable from any context without locks
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LATEST_READ_RETRIES 8
+
+typedef enum {
+    SAMPLE_QUALITY_NONE,   /**< Channel never received a value */
+    SAMPLE_QUALITY_GOOD,
+    SAMPLE_QUALITY_FAILED, /**< Last attempt to sample source failed, value is the previous one */
+} sample_quality_t;
+
+typedef struct {
+    int32_t value;
+    uint64_t timestamp_us; /**< Monotonic time of the reading */
+    sample_quality_t quality;
+} latest_value_t;
+
+/**
+ * @brief Stores value of channel, never blocks
+ * @note Each channel shall have a single writer
+ */
+void latest_write(sensor_data_type_t type, sensor_source_t source, int32_t value, uint64_t timestamp_us);
+
+/**
+ * @brief Changes quality of every channel of source, keeps their values
+ */
+void latest_set_source_quality(sensor_source_t source, sample_quality_t quality);
+
+/**
+ * @brief Reads consistent snapshot of channel
+ * @note Gives up after LATEST_READ_RETRIES concurrent writes, so it is safe in ISR
+ *       that may preempt the writer
+ *
+ * @return true - snapshot is consistent
+ */
+bool latest_read(sensor_data_type_t type, sensor_source_t source, latest_value_t* out);
@@ -0,0 +1,69 @@
+/**
+ * @file loadgen.h
+ * @brief Synthetic multi-channel sample source for pipeline scaling measurements
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "loadgen_config.h"
+#include "sensors.h"
+#include "sample_bus.h"
+#include "archivist.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    LOADGEN_PATTERN_CONSTANT,
+    LOADGEN_PATTERN_TRIANGLE,
+    LOADGEN_PATTERN_NOISE,
+    LOADGEN_PATTERN_SPIKES,     /**< Noise with a spike every few samples, exercises spike rejection */
+    LOADGEN_PATTERN_WINDOWS,    /**< Triangle published as decimated windows, every sample goes to burst log */
+    LOADGEN_PATTERN_COUNT
+} loadgen_pattern_t;
+
+/**
+ * @brief Counters of one step, differences between its end and beginning
+ */
+typedef struct {
+    uint16_t channels;
+    uint32_t generated;         /**< Samples published by the generator */
+    uint32_t elapsed_ms;
+    uint32_t publish_us;        /**< Time spent publishing */
+    sample_bus_stats_t bus;     /**< Pending and max lag are taken at the end of the step */
+    archivist_stats_t archivist;
+    uint32_t payload_bytes;
+    uint32_t program_bytes;
+} loadgen_result_t;
+
+/**
+ * @brief Selects load from build configuration, on host LOADGEN_CHANNELS, LOADGEN_RATE_HZ,
+ *        LOADGEN_PATTERN and LOADGEN_STEP_MS environment variables override it. Channels are limited
+ *        to LOADGEN_MAX_CHANNELS
+ *
+ * @return true - synthetic load replaces live acquisition
+ */
+bool loadgen_init(void);
+
+/**
+ * @brief Tells whether samples come from load generator instead of sensors
+ */
+bool loadgen_is_active(void);
+
+/**
+ * @brief Generates load in steps, channel count doubles every step up to the configured one
+ * @note Channels take type and source slots that have a fusion lane round robin. Archivist filters every
+ *       channel with its own state and stores one entry per channel and save, so filter work and stored
+ *       data grow with channels. CPU time per task, sample bus lag and drops, archivist stage counters and
+ *       flash bandwidth are logged after every step, returns after the last one
+ */
+void loadgen_run(void);
+
+/**
+ * @brief Publishes samples of channels evenly over one step at the configured rate, logs its counters
+ * @note Channel count above LOADGEN_MAX_CHANNELS is not routed by archivist
+ *
+ * @param result counters of the step
+ */
+void loadgen_step(uint16_t channels, loadgen_result_t* result);
@@ -0,0 +1,34 @@
+/**
+ * @file loadgen_config.h
+ * @brief Build options of synthetic load generator, shared by the generator and RTOS configuration
+ * @note Holds preprocessor definitions only, included from FreeRTOSConfig.h. Build system may set any of them
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+/* LOADGEN_CHANNELS 0 keeps live acquisition */
+#ifndef LOADGEN_CHANNELS
+#define LOADGEN_CHANNELS 0
+#endif
+#ifndef LOADGEN_RATE_HZ
+#define LOADGEN_RATE_HZ 10
+#endif
+#ifndef LOADGEN_PATTERN
+#define LOADGEN_PATTERN LOADGEN_PATTERN_TRIANGLE
+#endif
+#ifndef LOADGEN_STEP_MS
+#define LOADGEN_STEP_MS 10000
+#endif
+
+/* Channels the pipeline keeps own state for, on host the channel count comes from environment */
+#if defined(USE_HAL_DRIVER)
+#define LOADGEN_MAX_CHANNELS ((LOADGEN_CHANNELS > 0) ? LOADGEN_CHANNELS : 1)
+#else
+#define LOADGEN_MAX_CHANNELS 64
+#endif
+/* Archivist save period under synthetic load, stored data shall change within a step */
+#ifndef LOADGEN_SAVE_PERIOD_S
+#define LOADGEN_SAVE_PERIOD_S 1
+#endif
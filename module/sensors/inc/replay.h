@@ -0,0 +1,56 @@
+/**
+ * @file replay.h
+ * @brief Replay of recorded sample streams in place of live acquisition
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Recorded time is divided by the speed, 1 - real time */
+#ifndef REPLAY_SPEED
+#define REPLAY_SPEED 1
+#endif
+
+/**
+ * @brief Recorded sample, flash regions hold records back to back and an erased record ends the stream
+ */
+typedef union {
+    struct {
+        uint32_t time_ms;   /**< Time since start of recording */
+        uint8_t type;
+        uint8_t source;
+        uint16_t count;     /**< Readings decimated into the sample, 0 is treated as 1 */
+        int32_t value;
+        int16_t min_delta;  /**< Window extremes relative to the value */
+        int16_t max_delta;
+    };
+    uint8_t raw[16];
+} replay_record_t;
+
+/**
+ * @brief Selects replay source from build configuration, live acquisition is used when there is none
+ * @note Target replays flash region REPLAY_FLASH_ADDR of REPLAY_FLASH_SIZE bytes, memory driver shall
+ *       be initialized and the region shall lie beyond the ones archivist writes. Host replays text file
+ *       named by REPLAY_FILE environment variable, one record per line: time_ms,type,source,value[,count,min,max].
+ *       REPLAY_SPEED environment variable overrides the build speed on host.
+ *
+ * @return true - replay source is opened
+ */
+bool replay_init(void);
+
+/**
+ * @brief Tells whether samples come from replay instead of sensors
+ */
+bool replay_is_active(void);
+
+/**
+ * @brief Publishes every record of the source at its recorded time scaled by speed, returns at the end
+ * @note Sample timestamps follow recorded time from the replay start, so with speed above one they run
+ *       ahead of monotonic clock
+ */
+void replay_run(void);
@@ -0,0 +1,75 @@
+/**
+ * @file sample_bus.h
+ * @brief Publish/subscribe bus of sensor samples over a shared ring buffer
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLE_BUS_SIZE            32 /**< Shall be power of two */
+#define SAMPLE_BUS_MAX_SUBSCRIBERS 4
+
+/**
+ * @brief Reader of the bus, every subscriber walks the ring with its own index
+ */
+typedef struct {
+    const char* name;
+    uint32_t read_seq;  /**< Sequence number of the next sample to read */
+    uint32_t received;
+    uint32_t dropped;   /**< Samples overwritten before subscriber read them */
+    uint32_t max_lag;   /**< Highest number of pending samples seen, backpressure indicator */
+} sample_bus_subscriber_t;
+
+/**
+ * @brief Counters of the bus, subscriber counters are summed, lags are the worst among subscribers
+ */
+typedef struct {
+    uint32_t published;
+    uint32_t received;
+    uint32_t dropped;
+    uint32_t pending;
+    uint32_t max_lag;
+} sample_bus_stats_t;
+
+/**
+ * @brief Registers subscriber, it receives samples published from now on
+ *
+ * @return subscriber, NULL if all slots are taken
+ */
+sample_bus_subscriber_t* sample_bus_subscribe(const char* name);
+
+/**
+ * @brief Stores sample in ring, never blocks, the oldest sample is overwritten when full
+ * @note Safe for several producer tasks, not for interrupts
+ */
+void sample_bus_publish(const sensor_sample_t* sample);
+
+/**
+ * @brief Returns next sample in place without copying
+ * @note Pointer is valid until sample_bus_release()
+ *
+ * @return sample, NULL if nothing is pending
+ */
+const sensor_sample_t* sample_bus_peek(sample_bus_subscriber_t* subscriber);
+
+/**
+ * @brief Marks peeked sample as consumed
+ *
+ * @return false - sample was overwritten while it was read and shall be discarded
+ */
+bool sample_bus_release(sample_bus_subscriber_t* subscriber);
+
+/**
+ * @brief Collects counters of all subscribers
+ */
+void sample_bus_get_stats(sample_bus_stats_t* stats);
+
+/**
+ * @brief Logs counters of every subscriber
+ */
+void sample_bus_report(void);
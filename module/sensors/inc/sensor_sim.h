@@ -0,0 +1,43 @@
+/**
+ * @file sensor_sim.h
+ * @brief Register-level models of supported sensors on simulated I2C bus
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "sensors.h"
+#include "i2c_sim.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Simulated physical quantity, triangle wave with uniform noise in driver output units
+ */
+typedef struct {
+    int32_t base;
+    int32_t amplitude;
+    uint32_t period_ms;     /**< Virtual time period */
+    int32_t noise;          /**< Noise is within [-noise, noise] */
+} sensor_sim_waveform_t;
+
+/**
+ * @brief Attaches models of all supported sensors to simulated sensors bus
+ */
+void sensor_sim_init(void);
+
+/**
+ * @brief Replaces waveform of quantity measured by source
+ */
+void sensor_sim_set_waveform(sensor_source_t source, sensor_data_type_t type, const sensor_sim_waveform_t* waveform);
+
+/**
+ * @brief Sets fault pattern of source device
+ */
+void sensor_sim_set_faults(sensor_source_t source, const i2c_sim_faults_t* faults);
+
+/**
+ * @brief Plugs source device in or out of the bus
+ */
+void sensor_sim_set_attached(sensor_source_t source, bool attached);
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include "i2c_bus.h"
 #include <stdint.h>
+#include <stdbool.h>
 
  /**
   * @brief Sensors measurements data types
@@ -20,15 +22,155 @@ typedef enum {
     SENSOR_TYPE_COUNT,
 } sensor_data_type_t;
 
-typedef void (*sensor_reading_handler_t)(sensor_data_type_t, int32_t);
+/**
+ * @brief Devices producing measurements, one quantity may come from several sources
+ */
+typedef enum {
+    SENSOR_SOURCE_AHT20,
+    SENSOR_SOURCE_BMP280,
+    SENSOR_SOURCE_AGS02MA,
+    SENSOR_SOURCE_COUNT,
+} sensor_source_t;
+
+typedef void (*sensor_reading_handler_t)(sensor_data_type_t, sensor_source_t, int32_t);
+
+typedef enum {
+    SENSOR_FETCH_OK,
+    SENSOR_FETCH_NOT_READY, /**< Conversion still in progress, fetch shall be retried */
+    SENSOR_FETCH_CRC_ERROR, /**< Data arrived but failed integrity check, device is still responding */
+    SENSOR_FETCH_ERROR,
+} sensor_fetch_status_t;
+
+typedef struct {
+    uint64_t timestamp_us;  /**< Monotonic time of the reading */
+    sensor_data_type_t type;
+    sensor_source_t source;
+    int32_t value;          /**< Reading, mean of the window for burst samples */
+    int32_t min;            /**< Window extremes, equal to value for single readings */
+    int32_t max;
+    uint16_t count;         /**< Readings decimated into the sample, more than one for burst windows */
+    uint16_t channel;       /**< Synthetic load channel numbered from 1, 0 for sensor readings */
+} sensor_sample_t;
+
+/**
+ * @brief Sampling schedule statistics of one sensor
+ */
+typedef struct {
+    uint32_t scheduled;
+    uint32_t samples;
+    uint32_t overruns;      /**< Periods skipped because sampling was late by more than a period */
+    uint32_t jitter_sum_ms; /**< Lateness of samples against their schedule */
+    uint32_t jitter_max_ms;
+} sensor_schedule_stats_t;
+
+#define SENSOR_HISTOGRAM_BUCKETS 8
+
+/**
+ * @brief Acquisition health counters of one sensor
+ * @note Histogram bucket 0 counts values below its first edge, every next bucket doubles the edge,
+ *       the last one collects everything above
+ */
+typedef struct {
+    uint32_t transactions;  /**< Driver calls touching the bus */
+    uint32_t nacks;         /**< Transfers not acknowledged or failed on the bus */
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t not_ready;     /**< Polls that found conversion still in progress */
+    uint32_t last_good;     /**< Tick of the last good sample */
+    bool has_good;
+    uint32_t latency_hist[SENSOR_HISTOGRAM_BUCKETS];    /**< Driver call duration, first edge 128 us */
+    uint32_t conversion_hist[SENSOR_HISTOGRAM_BUCKETS]; /**< Conversion start to result, first edge 4 ms */
+} sensor_health_t;
+
+/**
+ * @brief Scans sensor i2c bus once and registers supported sensors found
+ */
+void sensor_discover(void);
+
+/**
+ * @brief Lets acquisition task discover sensors and start publishing samples to sample bus
+ */
+void sensor_acquisition_start(void);
+
+/**
+ * @brief Stores sample as the latest value of its source and publishes it to sample bus
+ * @note Entry of every sample source into the pipeline: live sensors, replay and synthetic load
+ */
+void sensor_publish(const sensor_sample_t* sample);
 
 /**
- * @brief Scanes sensor i2c bus and processes readings of supported ones
+ * @brief Requests burst acquisition, sensors supporting it are sampled at their burst period
+ *        and every window is published as one decimated sample per channel
  *
- * @param reading_handler handler for received readings
+ * @param window_ms burst duration
  */
-void sensor_process_reading(sensor_reading_handler_t reading_handler);
+void sensor_burst_start(uint32_t window_ms);
 
-void ags02ma_process_reading(sensor_reading_handler_t);
-void bmp280_process_reading(sensor_reading_handler_t);
-void aht20_process_reading(sensor_reading_handler_t);
+/**
+ * @brief Logs sampling schedule statistics of every sensor
+ */
+void sensor_schedule_report(void);
+
+/**
+ * @brief Logs error counters, latency histograms and age of the last good sample of every sensor
+ */
+void sensor_health_report(void);
+
+/** Measurement channels one sensor driver can provide */
+#define SENSOR_MAX_CHANNELS 2
+
+/**
+ * @brief Quantity produced by a sensor, value = physical value in unit * scale
+ */
+typedef struct {
+    sensor_data_type_t type;
+    const char* unit;
+    int32_t scale;
+} sensor_channel_t;
+
+/**
+ * @brief Sensor driver descriptor, everything acquisition needs to know about a device
+ */
+typedef struct {
+    const char* name;
+    i2c_bus_id_t bus;               /**< Each bus with sensors is served by its own acquisition worker */
+    uint8_t addr;                   /**< 7-bit address on the bus */
+    sensor_source_t source;
+    uint8_t channel_count;
+    sensor_channel_t channels[SENSOR_MAX_CHANNELS];
+    uint32_t conversion_time_ms;    /**< Nominal conversion time, sensors with a ready status are polled around it */
+    bool ready_polling;             /**< Fetch reports SENSOR_FETCH_NOT_READY while converting */
+    uint32_t period_ms;
+    uint32_t phase_ms;              /**< Offset of the first sample, spreads sensors over time */
+    uint32_t burst_period_ms;       /**< Sampling period in burst mode, 0 - burst is not supported */
+    bool (*init)(void);             /**< Optional, called after attach and after a failed fetch */
+    bool (*start_conversion)(void);
+    sensor_fetch_status_t (*fetch_result)(sensor_reading_handler_t);
+} sensor_driver_t;
+
+/**
+ * @brief Registers sensor driver descriptor at compile time
+ * @note Descriptors are collected by the linker into sensor_drivers section, a new sensor
+ *       only needs its driver file. Explicit alignment keeps compiler from padding descriptors,
+ *       so that the section stays an array:
+ *       SENSOR_DRIVER_REGISTER(foo) = { .name = "FOO", .addr = 0x40, ... };
+ */
+#define SENSOR_DRIVER_REGISTER(id) \
+    __attribute__((used, section("sensor_drivers"), aligned(__alignof__(sensor_driver_t)))) \
+    const sensor_driver_t sensor_driver_##id
+
+/**
+ * @brief Returns first registered sensor driver descriptor
+ *
+ * @param count number of registered descriptors
+ */
+const sensor_driver_t* sensor_drivers(uint32_t* count);
+
+/**
+ * @brief CRC8 used by sensors on the bus, polynomial 0x31, initial value 0xFF
+ *
+ * @param data received data buffer
+ * @param size size of data
+ * @return uint8_t crc
+ */
+uint8_t sensor_crc8(const uint8_t* data, uint8_t size);
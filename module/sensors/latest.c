@@ -0,0 +1,70 @@
+/**
+ * @file latest.c
+ * @brief Latest value of every (quantity, source) channel, readable from any context without locks
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "latest.h"
+
+/* Orders data accesses against sequence counter, emits dmb on Cortex-M7 */
+#define LATEST_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+typedef struct {
+    volatile uint32_t seq; /**< Odd while write is in progress */
+    volatile int32_t value;
+    volatile uint64_t timestamp_us;
+    volatile sample_quality_t quality;
+} latest_slot_t;
+
+static latest_slot_t slots[SENSOR_TYPE_COUNT][SENSOR_SOURCE_COUNT];
+
+static void slot_write_begin(latest_slot_t* slot) {
+    slot->seq++;
+    LATEST_BARRIER();
+}
+
+static void slot_write_end(latest_slot_t* slot) {
+    LATEST_BARRIER();
+    slot->seq++;
+}
+
+void latest_write(sensor_data_type_t type, sensor_source_t source, int32_t value, uint64_t timestamp_us) {
+    latest_slot_t* slot = &slots[type][source];
+    slot_write_begin(slot);
+    slot->value = value;
+    slot->timestamp_us = timestamp_us;
+    slot->quality = SAMPLE_QUALITY_GOOD;
+    slot_write_end(slot);
+}
+
+void latest_set_source_quality(sensor_source_t source, sample_quality_t quality) {
+    for (uint8_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        latest_slot_t* slot = &slots[type][source];
+        if (slot->quality == SAMPLE_QUALITY_NONE) {
+            continue;
+        }
+        slot_write_begin(slot);
+        slot->quality = quality;
+        slot_write_end(slot);
+    }
+}
+
+bool latest_read(sensor_data_type_t type, sensor_source_t source, latest_value_t* out) {
+    const latest_slot_t* slot = &slots[type][source];
+    for (uint8_t attempt = 0; attempt < LATEST_READ_RETRIES; attempt++) {
+        uint32_t seq = slot->seq;
+        if (seq & 1) {
+            continue;
+        }
+        LATEST_BARRIER();
+        out->value = slot->value;
+        out->timestamp_us = slot->timestamp_us;
+        out->quality = slot->quality;
+        LATEST_BARRIER();
+        if (slot->seq == seq) {
+            return true;
+        }
+    }
+    return false;
+}
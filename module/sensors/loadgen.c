@@ -0,0 +1,350 @@
+/**
+ * @file loadgen.c
+ * @brief Synthetic multi-channel sample source for pipeline scaling measurements
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "loadgen.h"
+#include "fusion.h"
+#include "wear.h"
+#include "monotime.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if !defined(USE_HAL_DRIVER)
+#include <stdlib.h>
+#endif
+
+#define LOADGEN_TRIANGLE_SAMPLES 64  /**< Samples of one channel per triangle period */
+#define LOADGEN_SPIKE_EVERY      16
+#define LOADGEN_WINDOW_READINGS  16  /**< Readings a decimated window claims to hold */
+#define LOADGEN_MAX_TASKS        16
+#define LOADGEN_MAX_SLOTS        (SENSOR_TYPE_COUNT * FUSION_MAX_SOURCES)
+#define LOADGEN_CPU_SAMPLE_MS    1000  /**< Run time counters wrap, they are sampled well within the wrap period */
+
+typedef struct {
+    int32_t base;
+    int32_t amplitude;
+} loadgen_range_t;
+
+/**
+ * @brief Type and source pair the pipeline routes to a fusion lane
+ */
+typedef struct {
+    sensor_data_type_t type;
+    sensor_source_t source;
+} loadgen_slot_t;
+
+/**
+ * @brief Counters at the beginning of a step
+ */
+typedef struct {
+    uint64_t time_us;
+    sample_bus_stats_t bus;
+    archivist_stats_t archivist;
+    uint32_t payload_bytes;
+    uint32_t program_bytes;
+} loadgen_snapshot_t;
+
+/* Plausible values in driver output units */
+static const loadgen_range_t ranges[SENSOR_TYPE_COUNT] = {
+    [SENSOR_TEMPERATURE] = {2200, 300},
+    [SENSOR_HUMIDITY] = {4500, 1000},
+    [SENSOR_PRESSURE] = {101325, 500},
+    [SENSOR_TVOC] = {200, 150},
+};
+
+static bool loadgen_active = false;
+static uint16_t max_channels = LOADGEN_CHANNELS;
+static uint32_t rate_hz = LOADGEN_RATE_HZ;
+static loadgen_pattern_t pattern = LOADGEN_PATTERN;
+static uint32_t step_ms = LOADGEN_STEP_MS;
+static uint32_t noise_state = 1;
+static loadgen_slot_t slots[LOADGEN_MAX_SLOTS];
+static uint8_t slot_count = 0;
+
+#if configGENERATE_RUN_TIME_STATS
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t run_time;      /**< Counter at the last sample */
+    uint64_t step_time;     /**< Run time accumulated over the step */
+} loadgen_task_time_t;
+
+static TaskStatus_t task_status[LOADGEN_MAX_TASKS];
+static UBaseType_t task_status_count = 0;
+static loadgen_task_time_t task_times[LOADGEN_MAX_TASKS];
+static uint8_t task_time_count = 0;
+static uint32_t total_run_time = 0;
+static uint64_t step_run_time = 0;
+#endif
+
+#if !defined(USE_HAL_DRIVER)
+static void loadgen_env(const char* name, uint32_t* value) {
+    const char* text = getenv(name);
+    if (text != NULL) {
+        *value = (uint32_t)strtoul(text, NULL, 0);
+    }
+}
+#endif
+
+bool loadgen_init(void) {
+#if !defined(USE_HAL_DRIVER)
+    uint32_t channels = max_channels;
+    uint32_t pattern_id = pattern;
+    loadgen_env("LOADGEN_CHANNELS", &channels);
+    loadgen_env("LOADGEN_RATE_HZ", &rate_hz);
+    loadgen_env("LOADGEN_PATTERN", &pattern_id);
+    loadgen_env("LOADGEN_STEP_MS", &step_ms);
+    max_channels = (channels <= UINT16_MAX) ? (uint16_t)channels : UINT16_MAX;
+    pattern = (pattern_id < LOADGEN_PATTERN_COUNT) ? (loadgen_pattern_t)pattern_id : LOADGEN_PATTERN_TRIANGLE;
+#endif
+    if (max_channels > LOADGEN_MAX_CHANNELS) {
+        SLOG_WARN("loadgen: %u channels requested, pipeline keeps state for %u", max_channels, LOADGEN_MAX_CHANNELS);
+        max_channels = LOADGEN_MAX_CHANNELS;
+    }
+    slot_count = 0;
+    for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        const fusion_config_t* config = fusion_get_config(type);
+        for (uint8_t lane = 0; lane < config->source_count; lane++) {
+            slots[slot_count++] = (loadgen_slot_t){type, config->sources[lane]};
+        }
+    }
+    loadgen_active = max_channels > 0 && rate_hz > 0 && step_ms > 0 && slot_count > 0;
+    if (loadgen_active) {
+        SLOG_INFO("loadgen: up to %u channels x %luHz over %u slots, pattern %u, step %lums", max_channels, rate_hz,
+            slot_count, pattern, step_ms);
+    }
+    return loadgen_active;
+}
+
+bool loadgen_is_active(void) {
+    return loadgen_active;
+}
+
+static int32_t loadgen_noise(int32_t span) {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    return (span > 0) ? (int32_t)(noise_state % (uint32_t)(2 * span + 1)) - span : 0;
+}
+
+static int32_t loadgen_triangle(const loadgen_range_t* range, uint32_t n) {
+    int32_t ramp = (int32_t)(n % LOADGEN_TRIANGLE_SAMPLES) * 4 * range->amplitude / LOADGEN_TRIANGLE_SAMPLES;
+    return range->base + ((ramp < 2 * range->amplitude) ? ramp - range->amplitude : 3 * range->amplitude - ramp);
+}
+
+/**
+ * @brief Builds n-th sample of channel, channels take routed type and source slots round robin
+ *        and are told apart by their channel number
+ */
+static void loadgen_sample(uint16_t channel, uint32_t n, sensor_sample_t* sample) {
+    const loadgen_slot_t* slot = &slots[channel % slot_count];
+    const loadgen_range_t* range = &ranges[slot->type];
+    int32_t value = range->base;
+    int32_t spread = 0;
+    switch (pattern) {
+    case LOADGEN_PATTERN_TRIANGLE:
+        /* Channels are phase shifted so that slots sharing a quantity do not move in lockstep */
+        value = loadgen_triangle(range, n + channel);
+        break;
+    case LOADGEN_PATTERN_NOISE:
+        value += loadgen_noise(range->amplitude / 10);
+        break;
+    case LOADGEN_PATTERN_SPIKES:
+        value += loadgen_noise(range->amplitude / 10);
+        if ((n + channel) % LOADGEN_SPIKE_EVERY == 0) {
+            value += 4 * range->amplitude;
+        }
+        break;
+    case LOADGEN_PATTERN_WINDOWS:
+        value = loadgen_triangle(range, n + channel);
+        spread = range->amplitude / 10;
+        break;
+    default:
+        break;
+    }
+    *sample = (sensor_sample_t){
+        .timestamp_us = monotime_now_us(),
+        .type = slot->type,
+        .source = slot->source,
+        .value = value,
+        .min = value - spread,
+        .max = value + spread,
+        .count = (pattern == LOADGEN_PATTERN_WINDOWS) ? LOADGEN_WINDOW_READINGS : 1,
+        .channel = channel + 1,
+    };
+}
+
+static void loadgen_snapshot(loadgen_snapshot_t* snapshot) {
+    snapshot->time_us = monotime_now_us();
+    sample_bus_get_stats(&snapshot->bus);
+    archivist_get_stats(&snapshot->archivist);
+    wear_get_bytes(&snapshot->payload_bytes, &snapshot->program_bytes);
+}
+
+#if configGENERATE_RUN_TIME_STATS
+static loadgen_task_time_t* loadgen_task_time(TaskHandle_t handle) {
+    for (uint8_t i = 0; i < task_time_count; i++) {
+        if (task_times[i].handle == handle) {
+            return &task_times[i];
+        }
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Adds run time of every task since the previous sample to the step totals
+ */
+static void loadgen_cpu_sample(void) {
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t total;
+    task_status_count = uxTaskGetSystemState(task_status, LOADGEN_MAX_TASKS, &total);
+    if (task_status_count == 0) {
+        return;
+    }
+    step_run_time += total - total_run_time;
+    total_run_time = total;
+    for (UBaseType_t i = 0; i < task_status_count; i++) {
+        const TaskStatus_t* status = &task_status[i];
+        loadgen_task_time_t* entry = loadgen_task_time(status->xHandle);
+        if (entry == NULL) {
+            /* Task seen for the first time, its time is counted from the next sample on */
+            if (task_time_count < LOADGEN_MAX_TASKS) {
+                task_times[task_time_count++] = (loadgen_task_time_t){status->xHandle, status->ulRunTimeCounter, 0};
+            }
+            continue;
+        }
+        entry->step_time += status->ulRunTimeCounter - entry->run_time;
+        entry->run_time = status->ulRunTimeCounter;
+    }
+#endif
+}
+
+/**
+ * @brief Starts accounting of a step, takes the baseline of every counter
+ */
+static void loadgen_cpu_start(void) {
+#if configGENERATE_RUN_TIME_STATS
+    loadgen_cpu_sample();
+    step_run_time = 0;
+    for (uint8_t i = 0; i < task_time_count; i++) {
+        task_times[i].step_time = 0;
+    }
+#endif
+}
+
+/**
+ * @brief Logs share of every task in the run time of the step
+ */
+static void loadgen_cpu_report(uint16_t channels) {
+#if configGENERATE_RUN_TIME_STATS
+    loadgen_cpu_sample();
+    if (task_status_count == 0 || step_run_time == 0) {
+        SLOG_WARN("loadgen: more than %u tasks, cpu time is not available", LOADGEN_MAX_TASKS);
+        return;
+    }
+    for (UBaseType_t i = 0; i < task_status_count; i++) {
+        const loadgen_task_time_t* entry = loadgen_task_time(task_status[i].xHandle);
+        uint32_t permille = (entry != NULL) ? (uint32_t)(entry->step_time * 1000 / step_run_time) : 0;
+        if (permille > 0) {
+            SLOG_INFO("loadgen %u ch: cpu %s %lu.%lu%%", channels, task_status[i].pcTaskName, permille / 10, permille % 10);
+        }
+    }
+#else
+    (void)channels;
+#endif
+}
+
+static void loadgen_report(const loadgen_result_t* result) {
+    uint16_t channels = result->channels;
+    uint32_t span_ms = (result->elapsed_ms > 0) ? result->elapsed_ms : 1;
+    SLOG_INFO("loadgen %u ch x %luHz: %lu samples in %lums, publish %luus", channels, rate_hz, result->generated,
+        result->elapsed_ms, result->publish_us);
+    SLOG_INFO("loadgen %u ch: bus received %lu dropped %lu pending %lu max lag %lu", channels, result->bus.received,
+        result->bus.dropped, result->bus.pending, result->bus.max_lag);
+    SLOG_INFO("loadgen %u ch: archivist received %lu (%lu/s) unrouted %lu filtered %lu burst %lu stored %lu", channels,
+        result->archivist.received, (uint32_t)((uint64_t)result->archivist.received * 1000 / span_ms),
+        result->archivist.unrouted, result->archivist.filtered, result->archivist.burst, result->archivist.stored);
+    SLOG_INFO("loadgen %u ch: flash payload %luB/s programmed %luB/s", channels,
+        (uint32_t)((uint64_t)result->payload_bytes * 1000 / span_ms), (uint32_t)((uint64_t)result->program_bytes * 1000 / span_ms));
+    loadgen_cpu_report(channels);
+}
+
+/**
+ * @brief Fills result with counter differences since the beginning of the step
+ */
+static void loadgen_result(const loadgen_snapshot_t* before, loadgen_result_t* result) {
+    loadgen_snapshot_t after;
+    loadgen_snapshot(&after);
+    result->elapsed_ms = (uint32_t)((after.time_us - before->time_us) / 1000);
+    result->bus = (sample_bus_stats_t){
+        .published = after.bus.published - before->bus.published,
+        .received = after.bus.received - before->bus.received,
+        .dropped = after.bus.dropped - before->bus.dropped,
+        .pending = after.bus.pending,
+        .max_lag = after.bus.max_lag,
+    };
+    result->archivist = (archivist_stats_t){
+        .received = after.archivist.received - before->archivist.received,
+        .unrouted = after.archivist.unrouted - before->archivist.unrouted,
+        .filtered = after.archivist.filtered - before->archivist.filtered,
+        .burst = after.archivist.burst - before->archivist.burst,
+        .stored = after.archivist.stored - before->archivist.stored,
+    };
+    result->payload_bytes = after.payload_bytes - before->payload_bytes;
+    result->program_bytes = after.program_bytes - before->program_bytes;
+}
+
+void loadgen_step(uint16_t channels, loadgen_result_t* result) {
+    loadgen_snapshot_t before;
+    loadgen_snapshot(&before);
+    loadgen_cpu_start();
+
+    /* Samples of all channels are spread evenly over the step, publishing catches up after every tick */
+    uint64_t total_rate = (uint64_t)channels * rate_hz;
+    uint64_t step_us = (uint64_t)step_ms * 1000;
+    uint32_t generated = 0;
+    uint64_t publish_us = 0;
+    uint64_t cpu_sample_us = 0;
+    for (;;) {
+        uint64_t now_us = monotime_now_us();
+        uint64_t elapsed_us = now_us - before.time_us;
+        if (elapsed_us >= step_us) {
+            break;
+        }
+        uint32_t due = (uint32_t)(elapsed_us * total_rate / 1000000);
+        for (; generated < due; generated++) {
+            sensor_sample_t sample;
+            loadgen_sample(generated % channels, generated / channels, &sample);
+            sensor_publish(&sample);
+        }
+        publish_us += monotime_now_us() - now_us;
+        if (elapsed_us - cpu_sample_us >= LOADGEN_CPU_SAMPLE_MS * 1000) {
+            cpu_sample_us = elapsed_us;
+            loadgen_cpu_sample();
+        }
+        osDelay(1);
+    }
+    result->channels = channels;
+    result->generated = generated;
+    result->publish_us = (uint32_t)publish_us;
+    loadgen_result(&before, result);
+    loadgen_report(result);
+}
+
+void loadgen_run(void) {
+    uint16_t channels = 1;
+    for (;;) {
+        loadgen_result_t result;
+        loadgen_step(channels, &result);
+        if (channels >= max_channels) {
+            break;
+        }
+        channels = (channels <= max_channels / 2) ? channels * 2 : max_channels;
+    }
+    SLOG_INFO("loadgen: finished at %u channels", channels);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file replay.c
+ * @brief Replay of recorded sample streams in place of live acquisition
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "replay.h"
+#include "monotime.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+
+#if defined(REPLAY_FLASH_ADDR)
+#include "memory.h"
+#endif
+#if !defined(USE_HAL_DRIVER)
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#define REPLAY_LINE_MAX 96
+
+typedef struct replay_reader replay_reader_t;
+
+/**
+ * @brief Sequential source of recorded samples
+ */
+struct replay_reader {
+    /** Reads next record, false - stream ended */
+    bool (*next)(replay_reader_t* reader, replay_record_t* record);
+    uint32_t addr;
+    uint32_t end;
+    void* file;
+};
+
+static replay_reader_t reader;
+static bool replay_active = false;
+static uint32_t replay_speed = REPLAY_SPEED;
+
+#if defined(REPLAY_FLASH_ADDR)
+static bool replay_flash_next(replay_reader_t* reader, replay_record_t* record) {
+    if (reader->addr + sizeof(*record) > reader->end) {
+        return false;
+    }
+    memory.read(record->raw, reader->addr, sizeof(*record));
+    reader->addr += sizeof(*record);
+    return record->time_ms != 0xFFFFFFFF;
+}
+#endif
+
+#if !defined(USE_HAL_DRIVER)
+static bool replay_file_next(replay_reader_t* reader, replay_record_t* record) {
+    char line[REPLAY_LINE_MAX];
+    while (fgets(line, sizeof(line), (FILE*)reader->file) != NULL) {
+        unsigned long time_ms;
+        unsigned type, source, count = 1;
+        long value, min, max;
+        int fields = sscanf(line, "%lu,%u,%u,%ld,%u,%ld,%ld", &time_ms, &type, &source, &value, &count, &min, &max);
+        if (fields < 4) {
+            /* Header and comment lines */
+            continue;
+        }
+        if (fields < 7) {
+            min = max = value;
+        }
+        *record = (replay_record_t){
+            .time_ms = (uint32_t)time_ms, .type = (uint8_t)type, .source = (uint8_t)source, .count = (uint16_t)count,
+            .value = (int32_t)value, .min_delta = (int16_t)(min - value), .max_delta = (int16_t)(max - value),
+        };
+        return true;
+    }
+    fclose((FILE*)reader->file);
+    reader->file = NULL;
+    return false;
+}
+#endif
+
+bool replay_init(void) {
+#if defined(REPLAY_FLASH_ADDR)
+    reader.next = replay_flash_next;
+    reader.addr = REPLAY_FLASH_ADDR;
+    reader.end = REPLAY_FLASH_ADDR + REPLAY_FLASH_SIZE;
+    replay_active = true;
+    SLOG_INFO("replay: flash 0x%06lX..0x%06lX x%lu", reader.addr, reader.end, replay_speed);
+#elif !defined(USE_HAL_DRIVER)
+    const char* path = getenv("REPLAY_FILE");
+    if (path == NULL) {
+        return false;
+    }
+    reader.file = fopen(path, "r");
+    if (reader.file == NULL) {
+        SLOG_ERROR("replay: failed to open %s", path);
+        return false;
+    }
+    const char* speed = getenv("REPLAY_SPEED");
+    if (speed != NULL && atoi(speed) > 0) {
+        replay_speed = (uint32_t)atoi(speed);
+    }
+    reader.next = replay_file_next;
+    replay_active = true;
+    SLOG_INFO("replay: file %s x%lu", path, replay_speed);
+#endif
+    return replay_active;
+}
+
+bool replay_is_active(void) {
+    return replay_active;
+}
+
+void replay_run(void) {
+    replay_record_t record;
+    uint32_t published = 0;
+    uint32_t skipped = 0;
+    uint32_t start = osKernelGetTickCount();
+    uint64_t start_us = monotime_now_us();
+    uint32_t first_ms = 0;
+    uint32_t last_ms = 0;
+
+    while (reader.next(&reader, &record)) {
+        if (record.type >= SENSOR_TYPE_COUNT || record.source >= SENSOR_SOURCE_COUNT) {
+            skipped++;
+            continue;
+        }
+        if (published == 0) {
+            first_ms = last_ms = record.time_ms;
+        }
+        /* Time never goes back, out of order records are published at once */
+        if ((int32_t)(record.time_ms - last_ms) > 0) {
+            last_ms = record.time_ms;
+        }
+        uint32_t due = start + (last_ms - first_ms) / replay_speed;
+        if ((int32_t)(due - osKernelGetTickCount()) > 0) {
+            osDelayUntil(due);
+        }
+
+        /* Samples carry recorded timeline, consumers follow it rather than the accelerated real time */
+        sensor_sample_t sample = {
+            .timestamp_us = start_us + (uint64_t)(last_ms - first_ms) * 1000,
+            .type = (sensor_data_type_t)record.type,
+            .source = (sensor_source_t)record.source,
+            .value = record.value,
+            .min = record.value + record.min_delta,
+            .max = record.value + record.max_delta,
+            .count = (record.count > 0) ? record.count : 1,
+        };
+        sensor_publish(&sample);
+        published++;
+    }
+    SLOG_INFO("replay: finished, %lu samples over %lums, %lu skipped", published, last_ms - first_ms, skipped);
+}
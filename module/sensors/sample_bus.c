@@ -0,0 +1,92 @@
+/**
+ * @file sample_bus.c
+ * @brief Publish/subscribe bus of sensor samples over a shared ring buffer
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "sample_bus.h"
+#include "slog.h"
+#include "cmsis_os2.h"
+#include <stddef.h>
+
+static sensor_sample_t ring[SAMPLE_BUS_SIZE];
+static volatile uint32_t write_seq = 0;
+static sample_bus_subscriber_t subscribers[SAMPLE_BUS_MAX_SUBSCRIBERS];
+static uint8_t subscriber_count = 0;
+
+sample_bus_subscriber_t* sample_bus_subscribe(const char* name) {
+    if (subscriber_count >= SAMPLE_BUS_MAX_SUBSCRIBERS) {
+        SLOG_ERROR("sample bus: no slot for subscriber %s", name);
+        return NULL;
+    }
+    sample_bus_subscriber_t* subscriber = &subscribers[subscriber_count++];
+    subscriber->name = name;
+    subscriber->read_seq = write_seq;
+    subscriber->received = 0;
+    subscriber->dropped = 0;
+    subscriber->max_lag = 0;
+    return subscriber;
+}
+
+void sample_bus_publish(const sensor_sample_t* sample) {
+    /* Acquisition workers of several buses publish, a slot is claimed and filled without preemption */
+    int32_t lock = osKernelLock();
+    ring[write_seq % SAMPLE_BUS_SIZE] = *sample;
+    write_seq++;
+    osKernelRestoreLock(lock);
+}
+
+const sensor_sample_t* sample_bus_peek(sample_bus_subscriber_t* subscriber) {
+    uint32_t lag = write_seq - subscriber->read_seq;
+    if (lag == 0) {
+        return NULL;
+    }
+    if (lag > subscriber->max_lag) {
+        subscriber->max_lag = lag;
+    }
+    if (lag > SAMPLE_BUS_SIZE) {
+        /* Lapped by producer, continue from the oldest sample still in ring */
+        subscriber->dropped += lag - SAMPLE_BUS_SIZE;
+        subscriber->read_seq = write_seq - SAMPLE_BUS_SIZE;
+    }
+    return &ring[subscriber->read_seq % SAMPLE_BUS_SIZE];
+}
+
+bool sample_bus_release(sample_bus_subscriber_t* subscriber) {
+    /* Slot is reused once producer is a whole ring ahead of it */
+    bool intact = write_seq - subscriber->read_seq <= SAMPLE_BUS_SIZE;
+    subscriber->read_seq++;
+    if (intact) {
+        subscriber->received++;
+    } else {
+        subscriber->dropped++;
+    }
+    return intact;
+}
+
+void sample_bus_get_stats(sample_bus_stats_t* stats) {
+    uint32_t published = write_seq;
+    *stats = (sample_bus_stats_t){.published = published};
+    for (uint8_t i = 0; i < subscriber_count; i++) {
+        const sample_bus_subscriber_t* subscriber = &subscribers[i];
+        uint32_t pending = published - subscriber->read_seq;
+        stats->received += subscriber->received;
+        stats->dropped += subscriber->dropped;
+        if (pending > stats->pending) {
+            stats->pending = pending;
+        }
+        if (subscriber->max_lag > stats->max_lag) {
+            stats->max_lag = subscriber->max_lag;
+        }
+    }
+}
+
+void sample_bus_report(void) {
+    SLOG_INFO("sample bus: %lu samples published", write_seq);
+    for (uint8_t i = 0; i < subscriber_count; i++) {
+        const sample_bus_subscriber_t* subscriber = &subscribers[i];
+        SLOG_INFO("sample bus %s: received %lu dropped %lu pending %lu max lag %lu", subscriber->name,
+            subscriber->received, subscriber->dropped, write_seq - subscriber->read_seq, subscriber->max_lag);
+    }
+}
@@ -0,0 +1,297 @@
+/**
+ * @file sensor_sim.c
+ * @brief Register-level models of supported sensors on simulated I2C bus
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "sensor_sim.h"
+
+#if I2C_SIM_ENABLED
+
+#include "slog.h"
+#include <string.h>
+
+#define AHT20_SIM_ADDR            0x38
+#define AHT20_SIM_CONVERSION_MS   80
+#define AHT20_SIM_STATUS_BUSY     0x80
+#define AHT20_SIM_STATUS_CAL      0x08
+#define AHT20_SIM_CMD_MEASURE     0xAC
+
+#define BMP280_SIM_ADDR           0x77
+#define BMP280_SIM_REG_CALIB      0x88
+#define BMP280_SIM_REG_ID         0xD0
+#define BMP280_SIM_REG_RESET      0xE0
+#define BMP280_SIM_REG_CTRL_MEAS  0xF4
+#define BMP280_SIM_REG_CONFIG     0xF5
+#define BMP280_SIM_REG_PRESS_MSB  0xF7
+#define BMP280_SIM_REG_TEMP_XLSB  0xFC
+#define BMP280_SIM_CHIP_ID        0x58
+#define BMP280_SIM_RESET_VALUE    0xB6
+#define BMP280_SIM_MODE_NORMAL    0x03
+#define BMP280_SIM_ADC_BITS       20
+
+#define AGS02MA_SIM_ADDR          0x1A
+#define AGS02MA_SIM_STATUS_BUSY   0x01
+#define AGS02MA_SIM_CONVERSION_MS 100
+
+typedef struct {
+    uint64_t busy_until;
+    uint8_t result[7];
+} aht20_sim_t;
+
+typedef struct {
+    uint8_t regs[256];
+    uint8_t pointer;
+} bmp280_sim_t;
+
+typedef struct {
+    uint64_t busy_until;
+} ags02ma_sim_t;
+
+typedef struct {
+    i2c_sim_device_t device;
+    sensor_sim_waveform_t waveforms[SENSOR_TYPE_COUNT];
+} sensor_model_t;
+
+/* Calibration example from BMP280 datasheet chapter 3.12 */
+static const int32_t bmp280_sim_calib[12] = {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+
+static aht20_sim_t aht20_sim;
+static bmp280_sim_t bmp280_sim;
+static ags02ma_sim_t ags02ma_sim;
+static sensor_model_t models[SENSOR_SOURCE_COUNT];
+static uint32_t noise_state = 0x2545F491;
+
+static int32_t waveform_value(const sensor_model_t* model, sensor_data_type_t type) {
+    const sensor_sim_waveform_t* waveform = &model->waveforms[type];
+    int64_t value = waveform->base;
+    if (waveform->period_ms > 0 && waveform->amplitude != 0) {
+        /* Triangle between base - amplitude and base + amplitude */
+        int64_t ramp = (int64_t)(i2c_sim_time_ms() % waveform->period_ms) * 4 * waveform->amplitude / waveform->period_ms;
+        value += (ramp < 2 * waveform->amplitude) ? ramp - waveform->amplitude : 3 * waveform->amplitude - ramp;
+    }
+    if (waveform->noise > 0) {
+        noise_state ^= noise_state << 13;
+        noise_state ^= noise_state >> 17;
+        noise_state ^= noise_state << 5;
+        value += (int32_t)(noise_state % (uint32_t)(2 * waveform->noise + 1)) - waveform->noise;
+    }
+    return (int32_t)value;
+}
+
+static uint32_t clamp_raw(int64_t raw, uint32_t bits) {
+    if (raw < 0) {
+        return 0;
+    }
+    return (raw >= (1L << bits)) ? (uint32_t)((1L << bits) - 1) : (uint32_t)raw;
+}
+
+/* AHT20: measurement command, then 7 bytes of status, 20-bit humidity, 20-bit temperature and CRC */
+
+static void aht20_sim_write(i2c_sim_device_t* device, const uint8_t* data, uint16_t len) {
+    if (len == 0 || data[0] != AHT20_SIM_CMD_MEASURE) {
+        return;
+    }
+    const sensor_model_t* model = &models[SENSOR_SOURCE_AHT20];
+    uint32_t raw_hum = clamp_raw((int64_t)waveform_value(model, SENSOR_HUMIDITY) * 1048576 / 10000, 20);
+    uint32_t raw_temp = clamp_raw(((int64_t)waveform_value(model, SENSOR_TEMPERATURE) + 5000) * 1048576 / 20000, 20);
+    uint32_t conversion_ms = AHT20_SIM_CONVERSION_MS;
+    if (i2c_sim_fault_hits(device, device->faults.not_ready_every)) {
+        conversion_ms *= 2;
+    }
+
+    aht20_sim.busy_until = i2c_sim_time_ms() + conversion_ms;
+    aht20_sim.result[1] = raw_hum >> 12;
+    aht20_sim.result[2] = raw_hum >> 4;
+    aht20_sim.result[3] = (raw_hum << 4) | (raw_temp >> 16);
+    aht20_sim.result[4] = raw_temp >> 8;
+    aht20_sim.result[5] = raw_temp;
+}
+
+static void aht20_sim_read(i2c_sim_device_t* device, uint8_t* data, uint16_t len) {
+    aht20_sim.result[0] = AHT20_SIM_STATUS_CAL;
+    if (i2c_sim_time_ms() < aht20_sim.busy_until) {
+        aht20_sim.result[0] |= AHT20_SIM_STATUS_BUSY;
+    }
+    aht20_sim.result[6] = sensor_crc8(aht20_sim.result, 6);
+    memcpy(data, aht20_sim.result, (len < sizeof(aht20_sim.result)) ? len : sizeof(aht20_sim.result));
+}
+
+/* BMP280: register file with auto-incremented pointer, data registers follow simulated quantities */
+
+static int32_t bmp280_sim_t_fine(int32_t adc_t) {
+    const int32_t* c = bmp280_sim_calib;
+    int32_t var1 = ((((adc_t >> 3) - (c[0] << 1))) * c[1]) >> 11;
+    int32_t var2 = (((((adc_t >> 4) - c[0]) * ((adc_t >> 4) - c[0])) >> 12) * c[2]) >> 14;
+    return var1 + var2;
+}
+
+static int64_t bmp280_sim_pressure(int32_t adc_p, int32_t t_fine) {
+    const int32_t* c = bmp280_sim_calib;
+    int64_t var1 = (int64_t)t_fine - 128000;
+    int64_t var2 = var1 * var1 * c[8];
+    var2 = var2 + ((var1 * c[7]) << 17);
+    var2 = var2 + ((int64_t)c[6] << 35);
+    var1 = ((var1 * var1 * c[5]) >> 8) + ((var1 * c[4]) << 12);
+    var1 = ((((int64_t)1 << 47) + var1) * c[3]) >> 33;
+    if (var1 == 0) {
+        return 0;
+    }
+    int64_t p = 1048576 - adc_p;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = ((int64_t)c[11] * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c[10] * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + ((int64_t)c[9] << 4);
+    return p >> 8;
+}
+
+/**
+ * @brief Finds raw ADC value that compensates to the target, compensation is monotonic in ADC value
+ */
+static int32_t bmp280_sim_adc_temperature(int32_t temperature) {
+    int32_t low = 0;
+    int32_t high = (1 << BMP280_SIM_ADC_BITS) - 1;
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (((bmp280_sim_t_fine(mid) * 5 + 128) >> 8) < temperature) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int32_t bmp280_sim_adc_pressure(int32_t pressure, int32_t t_fine) {
+    int32_t low = 0;
+    int32_t high = (1 << BMP280_SIM_ADC_BITS) - 1;
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (bmp280_sim_pressure(mid, t_fine) > pressure) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void bmp280_sim_reset(void) {
+    memset(bmp280_sim.regs, 0, sizeof(bmp280_sim.regs));
+    for (uint8_t i = 0; i < 12; i++) {
+        bmp280_sim.regs[BMP280_SIM_REG_CALIB + 2 * i] = (uint8_t)bmp280_sim_calib[i];
+        bmp280_sim.regs[BMP280_SIM_REG_CALIB + 2 * i + 1] = (uint8_t)(bmp280_sim_calib[i] >> 8);
+    }
+    bmp280_sim.regs[BMP280_SIM_REG_ID] = BMP280_SIM_CHIP_ID;
+    /* Data registers read 0x80000 until the first conversion */
+    bmp280_sim.regs[BMP280_SIM_REG_PRESS_MSB] = 0x80;
+    bmp280_sim.regs[BMP280_SIM_REG_PRESS_MSB + 3] = 0x80;
+}
+
+static void bmp280_sim_convert(i2c_sim_device_t* device) {
+    if ((bmp280_sim.regs[BMP280_SIM_REG_CTRL_MEAS] & 0x03) != BMP280_SIM_MODE_NORMAL
+        || i2c_sim_fault_hits(device, device->faults.not_ready_every)) {
+        return;
+    }
+    const sensor_model_t* model = &models[SENSOR_SOURCE_BMP280];
+    int32_t adc_t = bmp280_sim_adc_temperature(waveform_value(model, SENSOR_TEMPERATURE));
+    int32_t adc_p = bmp280_sim_adc_pressure(waveform_value(model, SENSOR_PRESSURE), bmp280_sim_t_fine(adc_t));
+    uint8_t* data = &bmp280_sim.regs[BMP280_SIM_REG_PRESS_MSB];
+    data[0] = adc_p >> 12;
+    data[1] = adc_p >> 4;
+    data[2] = (adc_p << 4) & 0xF0;
+    data[3] = adc_t >> 12;
+    data[4] = adc_t >> 4;
+    data[5] = (adc_t << 4) & 0xF0;
+}
+
+static void bmp280_sim_write(i2c_sim_device_t* device, const uint8_t* data, uint16_t len) {
+    if (len == 0) {
+        return;
+    }
+    bmp280_sim.pointer = data[0];
+    /* Write transfer is a sequence of register address and value pairs */
+    for (uint16_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = data[i];
+        if (reg == BMP280_SIM_REG_RESET) {
+            if (data[i + 1] == BMP280_SIM_RESET_VALUE) {
+                bmp280_sim_reset();
+            }
+        } else if (reg == BMP280_SIM_REG_CTRL_MEAS || reg == BMP280_SIM_REG_CONFIG) {
+            bmp280_sim.regs[reg] = data[i + 1];
+        }
+    }
+}
+
+static void bmp280_sim_read(i2c_sim_device_t* device, uint8_t* data, uint16_t len) {
+    if (bmp280_sim.pointer >= BMP280_SIM_REG_PRESS_MSB && bmp280_sim.pointer <= BMP280_SIM_REG_TEMP_XLSB) {
+        bmp280_sim_convert(device);
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = bmp280_sim.regs[bmp280_sim.pointer++];
+    }
+}
+
+/* AGS02MA: data register read returns status, 24-bit TVOC and CRC */
+
+static void ags02ma_sim_write(i2c_sim_device_t* device, const uint8_t* data, uint16_t len) {
+    uint32_t conversion_ms = AGS02MA_SIM_CONVERSION_MS;
+    if (i2c_sim_fault_hits(device, device->faults.not_ready_every)) {
+        conversion_ms *= 2;
+    }
+    ags02ma_sim.busy_until = i2c_sim_time_ms() + conversion_ms;
+}
+
+static void ags02ma_sim_read(i2c_sim_device_t* device, uint8_t* data, uint16_t len) {
+    uint32_t tvoc = clamp_raw(waveform_value(&models[SENSOR_SOURCE_AGS02MA], SENSOR_TVOC), 24);
+    uint8_t status = (i2c_sim_time_ms() < ags02ma_sim.busy_until) ? AGS02MA_SIM_STATUS_BUSY : 0;
+    uint8_t result[5] = {status, tvoc >> 16, tvoc >> 8, tvoc};
+    result[4] = sensor_crc8(result, 4);
+    memcpy(data, result, (len < sizeof(result)) ? len : sizeof(result));
+}
+
+static sensor_model_t models[SENSOR_SOURCE_COUNT] = {
+    [SENSOR_SOURCE_AHT20] = {
+        .device = {I2C_BUS_SENSORS, AHT20_SIM_ADDR, aht20_sim_write, aht20_sim_read, &aht20_sim, true},
+        .waveforms = {
+            [SENSOR_TEMPERATURE] = {2200, 300, 600000, 5},
+            [SENSOR_HUMIDITY] = {4500, 1000, 900000, 20},
+        },
+    },
+    [SENSOR_SOURCE_BMP280] = {
+        .device = {I2C_BUS_SENSORS, BMP280_SIM_ADDR, bmp280_sim_write, bmp280_sim_read, &bmp280_sim, true},
+        .waveforms = {
+            [SENSOR_TEMPERATURE] = {2250, 300, 600000, 3},
+            [SENSOR_PRESSURE] = {101325, 150, 3600000, 2},
+        },
+    },
+    [SENSOR_SOURCE_AGS02MA] = {
+        .device = {I2C_BUS_SENSORS, AGS02MA_SIM_ADDR, ags02ma_sim_write, ags02ma_sim_read, &ags02ma_sim, true},
+        .waveforms = {
+            [SENSOR_TVOC] = {150, 100, 300000, 10},
+        },
+    },
+};
+
+void sensor_sim_init(void) {
+    bmp280_sim_reset();
+    for (uint8_t source = 0; source < SENSOR_SOURCE_COUNT; source++) {
+        i2c_sim_add_device(&models[source].device);
+    }
+    SLOG_INFO("sensor sim: %u models attached", SENSOR_SOURCE_COUNT);
+}
+
+void sensor_sim_set_waveform(sensor_source_t source, sensor_data_type_t type, const sensor_sim_waveform_t* waveform) {
+    models[source].waveforms[type] = *waveform;
+}
+
+void sensor_sim_set_faults(sensor_source_t source, const i2c_sim_faults_t* faults) {
+    models[source].device.faults = *faults;
+}
+
+void sensor_sim_set_attached(sensor_source_t source, bool attached) {
+    models[source].device.attached = attached;
+}
+
+#endif /* I2C_SIM_ENABLED */
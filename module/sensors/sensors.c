@@ -6,43 +6,585 @@
  */
 
 #include "sensors.h"
+#include "sample_bus.h"
+#include "latest.h"
+#include "monotime.h"
 #include "slog.h"
-#include "i2c.h"
+#include "i2c_bus.h"
+#include "sensor_sim.h"
+#include "replay.h"
+#include "loadgen.h"
 #include "cmsis_os2.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
 
-typedef void (*process_reading_func_t)(sensor_reading_handler_t);
+#define SENSOR_REPROBE_CYCLES 10
+#define SENSOR_POLL_BACKOFF_MIN_MS 2
+#define SENSOR_POLL_BACKOFF_MAX_MS 16
+#define SENSOR_READY_TIMEOUT_FACTOR 2
+#define SENSOR_MAX_DRIVERS 8
+#define SENSOR_IDLE_PERIOD_MS 1000
+#define SENSOR_LATENCY_HIST_SHIFT 7     /**< First latency bucket edge 128 us */
+#define SENSOR_CONVERSION_HIST_SHIFT 2  /**< First conversion bucket edge 4 ms */
+#define SENSOR_WORKER_STACK_WORDS 512
 
+/**
+ * @brief Decimator of one channel in burst mode, window averaging is a first-order CIC
+ */
+typedef struct {
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    uint16_t count;
+} sensor_window_t;
+
+/**
+ * @brief Runtime state of a registered sensor
+ */
+typedef struct {
+    const sensor_driver_t* driver;
+    bool present;
+    bool initialized;
+    bool converting;
+    uint8_t reprobe_countdown;
+    uint32_t next_due;      /**< Tick of the next scheduled sample */
+    uint32_t ready_estimate_ms; /**< Learned conversion time, first poll happens after it */
+    uint32_t conversion_start;
+    uint32_t poll_at;
+    uint32_t poll_backoff_ms;
+    bool burst;
+    uint32_t burst_end;
+    sensor_window_t windows[SENSOR_MAX_CHANNELS];
+    sensor_schedule_stats_t stats;
+    sensor_health_t health;
+} sensor_state_t;
+
+/**
+ * @brief Acquisition worker of one bus, owns the schedule of sensors attached to it
+ */
 typedef struct {
-    uint8_t sensor_addr;
-    process_reading_func_t process_reading;
-} sensor_map_entry_t;
+    sensor_state_t* queue[SENSOR_MAX_DRIVERS];  /**< Sensors served by the worker */
+    int count;
+    uint32_t burst_seq;                         /**< Last burst request taken by the worker */
+} sensor_worker_t;
+
+/* Bounds of sensor_drivers section, provided by the linker */
+extern const sensor_driver_t __start_sensor_drivers[];
+extern const sensor_driver_t __stop_sensor_drivers[];
+
+static sensor_state_t sensors_map[SENSOR_MAX_DRIVERS];
+static int sensors_count = 0;
+
+static sensor_worker_t workers[I2C_BUS_COUNT];
+
+/* Worker of the first bus runs in acquisition task, the rest get their own threads */
+static uint32_t worker_stacks[I2C_BUS_COUNT - 1][SENSOR_WORKER_STACK_WORDS];
+static StaticTask_t worker_control_blocks[I2C_BUS_COUNT - 1];
+
+static volatile bool acquisition_started = false;
+static volatile uint32_t burst_request_ms = 0;
+static volatile uint32_t burst_request_seq = 0;
+
+static bool sensor_probe(const sensor_state_t* sensor, uint32_t trials) {
+    return i2c_bus_probe(sensor->driver->bus, sensor->driver->addr, trials);
+}
+
+const sensor_driver_t* sensor_drivers(uint32_t* count) {
+    *count = (uint32_t)(__stop_sensor_drivers - __start_sensor_drivers);
+    return __start_sensor_drivers;
+}
+
+uint8_t sensor_crc8(const uint8_t* data, uint8_t size) {
+    uint8_t crc = 0xFF;
+    for (uint8_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ 0x31;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Builds sensor table from registered driver descriptors
+ */
+static void sensor_register_drivers(void) {
+    uint32_t count;
+    const sensor_driver_t* drivers = sensor_drivers(&count);
+    if (count > SENSOR_MAX_DRIVERS) {
+        SLOG_ERROR("%lu sensor drivers registered, using first %u", count, SENSOR_MAX_DRIVERS);
+        count = SENSOR_MAX_DRIVERS;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (drivers[i].bus >= I2C_BUS_COUNT) {
+            SLOG_ERROR("sensor %s is on unknown bus %u", drivers[i].name, drivers[i].bus);
+            continue;
+        }
+        sensor_state_t* sensor = &sensors_map[sensors_count++];
+        sensor->driver = &drivers[i];
+        sensor_worker_t* worker = &workers[drivers[i].bus];
+        worker->queue[worker->count++] = sensor;
+        for (uint8_t c = 0; c < drivers[i].channel_count; c++) {
+            SLOG_DEBUG("sensor %s at %u:0x%02X: channel %u in %s x%ld", drivers[i].name, drivers[i].bus,
+                drivers[i].addr, c, drivers[i].channels[c].unit, drivers[i].channels[c].scale);
+        }
+    }
+}
+
+void sensor_discover(void) {
+    for (int i = 0; i < sensors_count; i++) {
+        sensors_map[i].present = false;
+        sensors_map[i].initialized = false;
+        sensors_map[i].reprobe_countdown = SENSOR_REPROBE_CYCLES;
+    }
+    for (i2c_bus_id_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+        if (workers[bus].count == 0) {
+            continue;
+        }
+        SLOG_DEBUG("sensors bus %u scan begin", bus);
+        for (uint8_t addr = 1; addr < 128; addr++) {
+            if (!i2c_bus_probe(bus, addr, 3)) {
+                continue;
+            }
+            bool supported = false;
+            for (int i = 0; i < workers[bus].count; i++) {
+                sensor_state_t* sensor = workers[bus].queue[i];
+                if (sensor->driver->addr == addr) {
+                    sensor->present = true;
+                    supported = true;
+                    SLOG_DEBUG("sensor %s found at %u:0x%02X", sensor->driver->name, bus, addr);
+                }
+            }
+            if (!supported) {
+                SLOG_WARN("reading not supported for device at %u:0x%02X", bus, addr);
+            }
+        }
+        SLOG_DEBUG("sensors bus %u scan end", bus);
+    }
+}
+
+static void sensor_check_detached(sensor_state_t* sensor) {
+    latest_set_source_quality(sensor->driver->source, SAMPLE_QUALITY_FAILED);
+    sensor->initialized = false;
+    if (!sensor_probe(sensor, 1)) {
+        SLOG_WARN("sensor at 0x%02X detached", sensor->driver->addr);
+        sensor->present = false;
+    }
+}
+
+void sensor_publish(const sensor_sample_t* sample) {
+    latest_write(sample->type, sample->source, sample->value, sample->timestamp_us);
+    sample_bus_publish(sample);
+}
+
+static void sensor_window_accumulate(sensor_state_t* sensor, sensor_data_type_t type, int32_t value) {
+    for (uint8_t c = 0; c < sensor->driver->channel_count; c++) {
+        sensor_window_t* window = &sensor->windows[c];
+        if (sensor->driver->channels[c].type != type || window->count == UINT16_MAX) {
+            continue;
+        }
+        if (window->count == 0 || value < window->min) {
+            window->min = value;
+        }
+        if (window->count == 0 || value > window->max) {
+            window->max = value;
+        }
+        window->sum += value;
+        window->count++;
+    }
+}
+
+static sensor_state_t* sensor_by_source(sensor_source_t source) {
+    for (int i = 0; i < sensors_count; i++) {
+        if (sensors_map[i].driver->source == source) {
+            return &sensors_map[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reading handler of drivers, readings taken in burst mode are decimated instead of published
+ * @note Called from workers of several buses, the sensor is found by source of the reading
+ */
+static void sensor_reading(sensor_data_type_t type, sensor_source_t source, int32_t value) {
+    sensor_state_t* sensor = sensor_by_source(source);
+    if (sensor != NULL && sensor->burst) {
+        sensor_window_accumulate(sensor, type, value);
+        return;
+    }
+    sensor_sample_t sample = {
+        .timestamp_us = monotime_now_us(), .type = type, .source = source, .value = value, .min = value, .max = value, .count = 1,
+    };
+    sensor_publish(&sample);
+}
+
+static void sensor_burst_begin(sensor_state_t* sensor, uint32_t now, uint32_t window_ms) {
+    if (sensor->driver->burst_period_ms == 0 || !sensor->present) {
+        return;
+    }
+    SLOG_DEBUG("sensor %s burst %lums every %lums", sensor->driver->name, window_ms, sensor->driver->burst_period_ms);
+    memset(sensor->windows, 0, sizeof(sensor->windows));
+    sensor->burst = true;
+    sensor->burst_end = now + window_ms;
+    sensor->next_due = now;
+}
+
+/**
+ * @brief Publishes one decimated sample per channel of the finished burst window
+ */
+static void sensor_burst_finish(sensor_state_t* sensor) {
+    uint64_t timestamp_us = monotime_now_us();
+    for (uint8_t c = 0; c < sensor->driver->channel_count; c++) {
+        const sensor_window_t* window = &sensor->windows[c];
+        if (window->count == 0) {
+            continue;
+        }
+        sensor_sample_t sample = {
+            .timestamp_us = timestamp_us,
+            .type = sensor->driver->channels[c].type,
+            .source = sensor->driver->source,
+            .value = (int32_t)(window->sum / window->count),
+            .min = window->min,
+            .max = window->max,
+            .count = window->count,
+        };
+        sensor_publish(&sample);
+    }
+    sensor->burst = false;
+}
+
+static void histogram_add(uint32_t hist[SENSOR_HISTOGRAM_BUCKETS], uint32_t value, uint8_t shift) {
+    value >>= shift;
+    uint32_t bucket = (value == 0) ? 0 : 32 - __builtin_clz(value);
+    hist[(bucket < SENSOR_HISTOGRAM_BUCKETS) ? bucket : SENSOR_HISTOGRAM_BUCKETS - 1]++;
+}
+
+/**
+ * @brief Accounts driver call duration, failed calls are classified by the last bus transfer status
+ */
+static void sensor_account_call(sensor_state_t* sensor, uint64_t start_us, bool failed) {
+    sensor_health_t* health = &sensor->health;
+    health->transactions++;
+    histogram_add(health->latency_hist, (uint32_t)(monotime_now_us() - start_us), SENSOR_LATENCY_HIST_SHIFT);
+    if (!failed) {
+        return;
+    }
+    switch (i2c_bus_last_status(sensor->driver->bus)) {
+    case I2C_STATUS_ERROR:
+        health->nacks++;
+        break;
+    case I2C_STATUS_TIMEOUT:
+    case I2C_STATUS_BUSY:
+        health->timeouts++;
+        break;
+    default:
+        break;
+    }
+}
+
+static bool sensor_init(sensor_state_t* sensor) {
+    if (sensor->driver->init == NULL) {
+        return true;
+    }
+    uint64_t start_us = monotime_now_us();
+    bool initialized = sensor->driver->init();
+    sensor_account_call(sensor, start_us, !initialized);
+    return initialized;
+}
 
-sensor_map_entry_t sensors_map[] = {
-    {0x1A, ags02ma_process_reading},
-    {0x38, aht20_process_reading},
-    {0x77, bmp280_process_reading},
-    /** add new sensors here */
-};
+static bool sensor_start_conversion(sensor_state_t* sensor) {
+    uint64_t start_us = monotime_now_us();
+    bool started = sensor->driver->start_conversion();
+    sensor_account_call(sensor, start_us, !started);
+    return started;
+}
+
+static sensor_fetch_status_t sensor_fetch_result(sensor_state_t* sensor) {
+    uint64_t start_us = monotime_now_us();
+    sensor_fetch_status_t status = sensor->driver->fetch_result(sensor_reading);
+    sensor_account_call(sensor, start_us, status == SENSOR_FETCH_ERROR);
+    return status;
+}
+
+static uint32_t sensor_period_ms(const sensor_state_t* sensor) {
+    return sensor->burst ? sensor->driver->burst_period_ms : sensor->driver->period_ms;
+}
+
+/**
+ * @brief Advances sensor schedule, records lateness of the sample and skipped periods
+ */
+static void sensor_schedule_advance(sensor_state_t* sensor, uint32_t now) {
+    uint32_t period_ms = sensor_period_ms(sensor);
+    uint32_t jitter_ms = now - sensor->next_due;
+    uint32_t missed = jitter_ms / period_ms;
+
+    sensor->stats.scheduled++;
+    sensor->stats.overruns += missed;
+    sensor->stats.jitter_sum_ms += jitter_ms % period_ms;
+    if (jitter_ms % period_ms > sensor->stats.jitter_max_ms) {
+        sensor->stats.jitter_max_ms = jitter_ms % period_ms;
+    }
+    sensor->next_due += (missed + 1) * period_ms;
+}
+
+/**
+ * @brief Starts conversion of sensor if it is due, re-probes absent ones from time to time
+ *
+ * @return true - conversion is started
+ */
+static bool sensor_start_if_due(sensor_state_t* sensor, uint32_t now) {
+    sensor->converting = false;
+    if (sensor->burst && (int32_t)(now - sensor->burst_end) >= 0) {
+        sensor_burst_finish(sensor);
+    }
+    if ((int32_t)(now - sensor->next_due) < 0) {
+        return false;
+    }
+    sensor_schedule_advance(sensor, now);
+
+    if (!sensor->present) {
+        /* Known but absent sensors are re-probed on a slow schedule to support hot-plug */
+        if (--sensor->reprobe_countdown > 0) {
+            return false;
+        }
+        sensor->reprobe_countdown = SENSOR_REPROBE_CYCLES;
+        if (!sensor_probe(sensor, 1)) {
+            return false;
+        }
+        SLOG_INFO("sensor %s at 0x%02X attached", sensor->driver->name, sensor->driver->addr);
+        sensor->present = true;
+        sensor->initialized = false;
+    }
+    if (!sensor->initialized) {
+        sensor->initialized = sensor_init(sensor);
+    }
+    if (!sensor->initialized || !sensor_start_conversion(sensor)) {
+        sensor_check_detached(sensor);
+        return false;
+    }
+    sensor->converting = true;
+    sensor->conversion_start = now;
+    sensor->poll_backoff_ms = SENSOR_POLL_BACKOFF_MIN_MS;
+    sensor->poll_at = now + (sensor->driver->ready_polling ? sensor->ready_estimate_ms : sensor->driver->conversion_time_ms);
+    return true;
+}
+
+/**
+ * @brief Adapts expected conversion time of a polled sensor to the observed one
+ *
+ * @param first_poll result was ready at the first poll, real conversion may be shorter
+ */
+static void sensor_learn_ready_time(sensor_state_t* sensor, uint32_t elapsed_ms, bool first_poll) {
+    if (first_poll) {
+        sensor->ready_estimate_ms -= sensor->ready_estimate_ms / 8;
+    } else {
+        sensor->ready_estimate_ms = (sensor->ready_estimate_ms * 3 + elapsed_ms) / 4;
+    }
+    if (sensor->ready_estimate_ms > sensor->driver->conversion_time_ms) {
+        sensor->ready_estimate_ms = sensor->driver->conversion_time_ms;
+    }
+}
+
+/**
+ * @brief Fetches result of converting sensor if its poll time has come
+ *
+ * @return true - sensor is still converting
+ */
+static bool sensor_poll_result(sensor_state_t* sensor, uint32_t now) {
+    if ((int32_t)(now - sensor->poll_at) < 0) {
+        return true;
+    }
+    sensor_fetch_status_t status = sensor_fetch_result(sensor);
+    uint32_t elapsed_ms = now - sensor->conversion_start;
+    bool first_poll = sensor->poll_backoff_ms == SENSOR_POLL_BACKOFF_MIN_MS;
 
-const int sensors_count = sizeof(sensors_map) / sizeof(sensor_map_entry_t);
+    if (status == SENSOR_FETCH_NOT_READY) {
+        sensor->health.not_ready++;
+    }
+    if (status == SENSOR_FETCH_NOT_READY && elapsed_ms < sensor->driver->conversion_time_ms * SENSOR_READY_TIMEOUT_FACTOR) {
+        sensor->poll_at = now + sensor->poll_backoff_ms;
+        if (sensor->poll_backoff_ms < SENSOR_POLL_BACKOFF_MAX_MS) {
+            sensor->poll_backoff_ms *= 2;
+        }
+        return true;
+    }
 
-static void process_reading_by_sensor_addr(uint8_t addr, sensor_reading_handler_t reading_handler) {
+    sensor->converting = false;
+    if (status == SENSOR_FETCH_OK) {
+        sensor->stats.samples++;
+        sensor->health.has_good = true;
+        sensor->health.last_good = now;
+        histogram_add(sensor->health.conversion_hist, elapsed_ms, SENSOR_CONVERSION_HIST_SHIFT);
+        if (sensor->driver->ready_polling) {
+            sensor_learn_ready_time(sensor, elapsed_ms, first_poll);
+        }
+    } else if (status == SENSOR_FETCH_CRC_ERROR) {
+        /* Device answered, the sample is lost but there is no reason to suspect detach */
+        sensor->health.crc_errors++;
+    } else {
+        if (status == SENSOR_FETCH_NOT_READY) {
+            SLOG_WARN("sensor at 0x%02X not ready after %lums", sensor->driver->addr, elapsed_ms);
+        }
+        sensor_check_detached(sensor);
+    }
+    return false;
+}
+
+void sensor_acquisition_start(void) {
+    acquisition_started = true;
+}
+
+void sensor_burst_start(uint32_t window_ms) {
+    burst_request_ms = window_ms;
+    burst_request_seq++;
+}
+
+void sensor_schedule_report(void) {
+    for (int i = 0; i < sensors_count; i++) {
+        const sensor_state_t* sensor = &sensors_map[i];
+        const sensor_schedule_stats_t* stats = &sensor->stats;
+        uint32_t jitter_avg_ms = (stats->scheduled > 0) ? stats->jitter_sum_ms / stats->scheduled : 0;
+        SLOG_INFO("sensor %s 0x%02X %s: period %lums samples %lu overruns %lu jitter avg %lums max %lums",
+            sensor->driver->name, sensor->driver->addr, sensor->present ? "present" : "absent", sensor->driver->period_ms,
+            stats->samples, stats->overruns, jitter_avg_ms, stats->jitter_max_ms);
+    }
+}
+
+static void histogram_report(const char* name, const char* label, const uint32_t hist[SENSOR_HISTOGRAM_BUCKETS]) {
+    SLOG_INFO("sensor %s %s: %lu %lu %lu %lu %lu %lu %lu %lu", name, label, hist[0], hist[1], hist[2], hist[3],
+        hist[4], hist[5], hist[6], hist[7]);
+}
+
+void sensor_health_report(void) {
+    uint32_t now = osKernelGetTickCount();
     for (int i = 0; i < sensors_count; i++) {
-        if (sensors_map[i].sensor_addr == addr) {
-            sensors_map[i].process_reading(reading_handler);
-            return;
+        const sensor_state_t* sensor = &sensors_map[i];
+        const sensor_health_t* health = &sensor->health;
+        SLOG_INFO("sensor %s: calls %lu nack %lu timeout %lu crc %lu not-ready %lu", sensor->driver->name,
+            health->transactions, health->nacks, health->timeouts, health->crc_errors, health->not_ready);
+        if (health->has_good) {
+            uint32_t age_ms = (uint32_t)((uint64_t)(now - health->last_good) * 1000 / osKernelGetTickFreq());
+            SLOG_INFO("sensor %s: last good sample %lums ago", sensor->driver->name, age_ms);
+        } else {
+            SLOG_INFO("sensor %s: no good sample yet", sensor->driver->name);
         }
+        histogram_report(sensor->driver->name, "call us <128..>8192", health->latency_hist);
+        histogram_report(sensor->driver->name, "conversion ms <4..>256", health->conversion_hist);
     }
-    SLOG_WARN("reading not supported for device at 0x%02X", addr);
 }
 
-void sensor_process_reading(sensor_reading_handler_t reading_handler) {
-    SLOG_DEBUG("sensors bus scan begin");
-    for (uint8_t addr = 1; addr < 128; addr++) {
-        if (HAL_I2C_IsDeviceReady(&sens_i2c, (addr << 1), 3, 5) == HAL_OK) {
-            SLOG_DEBUG("sensor found at 0x%02X", addr);
-            process_reading_by_sensor_addr(addr, reading_handler);
+/**
+ * @brief Samples every sensor of the worker bus on its own period, conversions that are due together run concurrently
+ * @note Workers of different buses run in parallel, transfers are serialized only by the lock of their bus
+ */
+static void sensor_worker_run(sensor_worker_t* worker) {
+    uint32_t start = osKernelGetTickCount();
+    for (int i = 0; i < worker->count; i++) {
+        worker->queue[i]->next_due = start + worker->queue[i]->driver->phase_ms;
+        worker->queue[i]->ready_estimate_ms = worker->queue[i]->driver->conversion_time_ms;
+    }
+    worker->burst_seq = burst_request_seq;
+
+    for (;;) {
+        uint32_t now = osKernelGetTickCount();
+        if (worker->burst_seq != burst_request_seq) {
+            worker->burst_seq = burst_request_seq;
+            for (int i = 0; i < worker->count; i++) {
+                sensor_burst_begin(worker->queue[i], now, burst_request_ms);
+            }
+        }
+        uint32_t next_due = now + SENSOR_IDLE_PERIOD_MS;
+        for (int i = 0; i < worker->count; i++) {
+            if ((int32_t)(worker->queue[i]->next_due - next_due) < 0) {
+                next_due = worker->queue[i]->next_due;
+            }
+        }
+        if ((int32_t)(next_due - now) > 0) {
+            osDelayUntil(next_due);
+        }
+
+        now = osKernelGetTickCount();
+        bool any_converting = false;
+        for (int i = 0; i < worker->count; i++) {
+            any_converting |= sensor_start_if_due(worker->queue[i], now);
+        }
+
+        /* Collect results as soon as each sensor is expected to be ready */
+        while (any_converting) {
+            uint32_t poll_at = 0;
+            bool poll_at_set = false;
+            for (int i = 0; i < worker->count; i++) {
+                sensor_state_t* sensor = worker->queue[i];
+                if (sensor->converting && (!poll_at_set || (int32_t)(sensor->poll_at - poll_at) < 0)) {
+                    poll_at = sensor->poll_at;
+                    poll_at_set = true;
+                }
+            }
+            if ((int32_t)(poll_at - osKernelGetTickCount()) > 0) {
+                osDelayUntil(poll_at);
+            }
+
+            now = osKernelGetTickCount();
+            any_converting = false;
+            for (int i = 0; i < worker->count; i++) {
+                sensor_state_t* sensor = worker->queue[i];
+                if (sensor->converting) {
+                    any_converting |= sensor_poll_result(sensor, now);
+                }
+            }
+        }
+    }
+}
+
+static void sensor_worker_task(void* argument) {
+    sensor_worker_run((sensor_worker_t*)argument);
+}
+
+/**
+ * @brief Discovers sensors and starts acquisition worker on every bus that has sensors
+ */
+void acquisition_task(void* argument) {
+    while (!acquisition_started) {
+        osDelay(10);
+    }
+    if (replay_is_active() || loadgen_is_active()) {
+        /* Recorded or synthetic samples stand in for live sensors, the bus is left alone */
+        if (replay_is_active()) {
+            replay_run();
+        } else {
+            loadgen_run();
+        }
+        for (;;) {
+            osDelay(SENSOR_IDLE_PERIOD_MS);
+        }
+    }
+#if I2C_SIM_ENABLED
+    sensor_sim_init();
+#endif
+    sensor_register_drivers();
+    sensor_discover();
+
+    for (i2c_bus_id_t bus = 1; bus < I2C_BUS_COUNT; bus++) {
+        if (workers[bus].count == 0) {
+            continue;
+        }
+        const osThreadAttr_t attributes = {
+            .name = "sensorWorker",
+            .cb_mem = &worker_control_blocks[bus - 1],
+            .cb_size = sizeof(worker_control_blocks[bus - 1]),
+            .stack_mem = &worker_stacks[bus - 1][0],
+            .stack_size = sizeof(worker_stacks[bus - 1]),
+            .priority = osThreadGetPriority(osThreadGetId()),
+        };
+        if (osThreadNew(sensor_worker_task, &workers[bus], &attributes) == NULL) {
+            SLOG_ERROR("failed to start sensors worker of bus %u", bus);
         }
     }
-    SLOG_DEBUG("sensors bus scan end");
+    sensor_worker_run(&workers[0]);
 }
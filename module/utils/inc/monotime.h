@@ -0,0 +1,42 @@
+/**
+ * @file monotime.h
+ * @brief Monotonic microsecond clock anchored to RTC time
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Starts cycle counter and keeps its overflows accounted
+ * @note Shall be called before kernel start
+ */
+void monotime_init(void);
+
+/**
+ * @brief Returns microseconds since monotime_init(), never goes back
+ */
+uint64_t monotime_now_us(void);
+
+/**
+ * @brief Returns raw cycle counter for short measurements, wraps every ~19.9 s
+ * @note Counts CPU cycles on target and nanoseconds on host
+ */
+uint32_t monotime_cycles(void);
+
+/**
+ * @brief Ties RTC time to the current monotonic time
+ *
+ * @param timestamp RTC unix timestamp
+ * @param fraction_us time elapsed since the start of RTC second
+ */
+void monotime_anchor(uint32_t timestamp, uint32_t fraction_us);
+
+/**
+ * @brief Converts monotonic time to unix timestamp using the latest anchor
+ *
+ * @return timestamp, 0 if clock was never anchored
+ */
+uint32_t monotime_to_timestamp(uint64_t time_us);
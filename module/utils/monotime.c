@@ -0,0 +1,99 @@
+/**
+ * @file monotime.c
+ * @brief Monotonic microsecond clock anchored to RTC time
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "monotime.h"
+#include <stdbool.h>
+
+static uint32_t anchor_timestamp = 0;
+static uint64_t anchor_time_us = 0;
+static bool anchored = false;
+
+#ifdef USE_HAL_DRIVER
+
+#include "main.h"
+#include "cmsis_os2.h"
+
+/* Cycle counter wraps every ~19.9 s at 216 MHz, it is sampled more often to count wraps */
+#define MONOTIME_WRAP_CHECK_PERIOD_MS 5000
+
+static uint32_t last_cycles = 0;
+static uint32_t cycles_high = 0;
+
+static void wrap_check_periodic_cb(void* argument) {
+    (void)monotime_now_us();
+}
+
+void monotime_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; /* Unlocks DWT on Cortex-M7 */
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    osTimerId_t wrap_check_periodic = osTimerNew(wrap_check_periodic_cb, osTimerPeriodic, NULL, NULL);
+    osTimerStart(wrap_check_periodic, MONOTIME_WRAP_CHECK_PERIOD_MS);
+}
+
+uint64_t monotime_now_us(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t cycles = DWT->CYCCNT;
+    if (cycles < last_cycles) {
+        cycles_high++;
+    }
+    last_cycles = cycles;
+    uint64_t total_cycles = ((uint64_t)cycles_high << 32) | cycles;
+    __set_PRIMASK(primask);
+    return total_cycles / (SystemCoreClock / 1000000);
+}
+
+uint32_t monotime_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+#else
+
+#include <time.h>
+
+static uint64_t start_us = 0;
+
+static uint64_t host_clock_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void monotime_init(void) {
+    start_us = host_clock_us();
+}
+
+uint64_t monotime_now_us(void) {
+    return host_clock_us() - start_us;
+}
+
+uint32_t monotime_cycles(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+
+#endif
+
+void monotime_anchor(uint32_t timestamp, uint32_t fraction_us) {
+    anchor_time_us = monotime_now_us() - fraction_us;
+    anchor_timestamp = timestamp;
+    anchored = true;
+}
+
+uint32_t monotime_to_timestamp(uint64_t time_us) {
+    if (!anchored) {
+        return 0;
+    }
+    int64_t offset_us = (int64_t)(time_us - anchor_time_us);
+    /* Floor division, so that times before anchor map to previous seconds */
+    int64_t offset_s = (offset_us >= 0) ? offset_us / 1000000 : -((-offset_us + 999999) / 1000000);
+    return (uint32_t)((int64_t)anchor_timestamp + offset_s);
+}
@@ -153,6 +153,15 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Task run time is only counted in load generator builds, which report it as CPU time. The counter is
+   read on every context switch, so it is DWT cycle counter register enabled by monotime_init. It wraps
+   every ~19.9 s, the load generator samples it more often than that */
+#include "loadgen_config.h"
+#if LOADGEN_CHANNELS > 0
+#define configGENERATE_RUN_TIME_STATS            1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         (*(volatile uint32_t*)0xE0001004UL)
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -25,6 +25,8 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "i2c_bus.h"
+#include "monotime.h"
 
 /* USER CODE END Includes */
 
@@ -96,6 +98,18 @@ const osThreadAttr_t Archivist_attributes = {
   .stack_size = sizeof(ArchivistBuffer),
   .priority = (osPriority_t) osPriorityNormal,
 };
+/* Definitions for Acquisition */
+osThreadId_t AcquisitionHandle;
+uint32_t AcquisitionBuffer[ 512 ];
+osStaticThreadDef_t AcquisitionControlBlock;
+const osThreadAttr_t Acquisition_attributes = {
+  .name = "Acquisition",
+  .cb_mem = &AcquisitionControlBlock,
+  .cb_size = sizeof(AcquisitionControlBlock),
+  .stack_mem = &AcquisitionBuffer[0],
+  .stack_size = sizeof(AcquisitionBuffer),
+  .priority = (osPriority_t) osPriorityAboveNormal,
+};
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
@@ -106,6 +120,7 @@ void startup_task(void *argument);
 void cli_task(void *argument);
 void slog_print_task(void *argument);
 void archivist_task(void *argument);
+void acquisition_task(void *argument);
 
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
@@ -121,6 +136,7 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_MUTEX */
   /* add mutexes, ... */
+  i2c_bus_init();
   /* USER CODE END RTOS_MUTEX */
 
   /* USER CODE BEGIN RTOS_SEMAPHORES */
@@ -129,6 +145,7 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_TIMERS */
   /* start timers, add new ones, ... */
+  monotime_init();
   /* USER CODE END RTOS_TIMERS */
 
   /* USER CODE BEGIN RTOS_QUEUES */
@@ -148,6 +165,9 @@ void MX_FREERTOS_Init(void) {
   /* creation of Archivist */
   ArchivistHandle = osThreadNew(archivist_task, NULL, &Archivist_attributes);
 
+  /* creation of Acquisition */
+  AcquisitionHandle = osThreadNew(acquisition_task, NULL, &Acquisition_attributes);
+
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
   /* USER CODE END RTOS_THREADS */
@@ -230,6 +250,24 @@ __weak void archivist_task(void *argument)
   /* USER CODE END archivist_task */
 }
 
+/* USER CODE BEGIN Header_acquisition_task */
+/**
+* @brief Function implementing the Acquisition thread.
+* @param argument: Not used
+* @retval None
+*/
+/* USER CODE END Header_acquisition_task */
+__weak void acquisition_task(void *argument)
+{
+  /* USER CODE BEGIN acquisition_task */
+  /* Infinite loop */
+  for(;;)
+  {
+    osDelay(1);
+  }
+  /* USER CODE END acquisition_task */
+}
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
@@ -0,0 +1,301 @@
+/**
+ * @file cmsis_os2_host.c
+ * @brief CMSIS-RTOS2 subset on POSIX threads, kernel tick follows host monotonic clock in milliseconds,
+ *        every timer runs its callback from a thread of its own
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "cmsis_os2.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+#define HOST_TICK_FREQ 1000
+
+/**
+ * @brief Host thread, thread flags are guarded by its own lock
+ */
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t flags;
+    osThreadFunc_t func;
+    void* argument;
+} host_thread_t;
+
+/**
+ * @brief Host timer, started timer thread sleeps until the expiry and calls back
+ */
+typedef struct {
+    pthread_t thread;
+    osTimerFunc_t func;
+    osTimerType_t type;
+    void* argument;
+    uint32_t period;
+    bool started;
+} host_timer_t;
+
+static uint64_t start_ms;
+static pthread_once_t start_once = PTHREAD_ONCE_INIT;
+static __thread host_thread_t* current_thread;
+static __thread int32_t kernel_locked;
+static pthread_mutex_t kernel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t host_now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void host_sleep_ms(uint32_t ms) {
+    struct timespec duration = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000};
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+ * @brief Converts timeout in ticks to absolute deadline of clock used by condition variables and mutexes
+ */
+static struct timespec host_deadline(uint32_t timeout) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / HOST_TICK_FREQ;
+    deadline.tv_nsec += (long)(timeout % HOST_TICK_FREQ) * (1000000000 / HOST_TICK_FREQ);
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    return deadline;
+}
+
+static host_thread_t* host_thread_new(void) {
+    host_thread_t* thread = calloc(1, sizeof(host_thread_t));
+    if (thread != NULL) {
+        pthread_mutex_init(&thread->lock, NULL);
+        pthread_cond_init(&thread->cond, NULL);
+    }
+    return thread;
+}
+
+static void* host_thread_entry(void* argument) {
+    current_thread = argument;
+    current_thread->func(current_thread->argument);
+    return NULL;
+}
+
+static void host_start_init(void) {
+    start_ms = host_now_ms();
+}
+
+uint32_t osKernelGetTickCount(void) {
+    pthread_once(&start_once, host_start_init);
+    return (uint32_t)(host_now_ms() - start_ms);
+}
+
+uint32_t osKernelGetTickFreq(void) {
+    return HOST_TICK_FREQ;
+}
+
+/**
+ * @brief Scheduler lock is a global lock on host, it serializes critical sections of locking threads only
+ */
+int32_t osKernelLock(void) {
+    int32_t previous = kernel_locked;
+    if (!previous) {
+        pthread_mutex_lock(&kernel_lock);
+        kernel_locked = 1;
+    }
+    return previous;
+}
+
+int32_t osKernelUnlock(void) {
+    int32_t previous = kernel_locked;
+    if (previous) {
+        kernel_locked = 0;
+        pthread_mutex_unlock(&kernel_lock);
+    }
+    return previous;
+}
+
+int32_t osKernelRestoreLock(int32_t lock) {
+    if (lock) {
+        osKernelLock();
+    } else {
+        osKernelUnlock();
+    }
+    return lock;
+}
+
+osStatus_t osDelay(uint32_t ticks) {
+    host_sleep_ms(ticks * 1000 / HOST_TICK_FREQ);
+    return osOK;
+}
+
+osStatus_t osDelayUntil(uint32_t ticks) {
+    int32_t left = (int32_t)(ticks - osKernelGetTickCount());
+    if (left > 0) {
+        host_sleep_ms((uint32_t)left * 1000 / HOST_TICK_FREQ);
+    }
+    return osOK;
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void* argument, const osThreadAttr_t* attr) {
+    host_thread_t* thread = host_thread_new();
+    if (thread == NULL) {
+        return NULL;
+    }
+    thread->func = func;
+    thread->argument = argument;
+    if (pthread_create(&thread->thread, NULL, host_thread_entry, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    pthread_detach(thread->thread);
+    return thread;
+}
+
+/**
+ * @brief Threads not created with osThreadNew, like main one, get their state on first use
+ */
+osThreadId_t osThreadGetId(void) {
+    if (current_thread == NULL) {
+        current_thread = host_thread_new();
+    }
+    return current_thread;
+}
+
+osPriority_t osThreadGetPriority(osThreadId_t thread_id) {
+    return osPriorityNormal;
+}
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags) {
+    host_thread_t* thread = thread_id;
+    if (thread == NULL) {
+        return (uint32_t)osFlagsErrorParameter;
+    }
+    pthread_mutex_lock(&thread->lock);
+    thread->flags |= flags;
+    uint32_t result = thread->flags;
+    pthread_cond_broadcast(&thread->cond);
+    pthread_mutex_unlock(&thread->lock);
+    return result;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags) {
+    host_thread_t* thread = osThreadGetId();
+    pthread_mutex_lock(&thread->lock);
+    uint32_t result = thread->flags;
+    thread->flags &= ~flags;
+    pthread_mutex_unlock(&thread->lock);
+    return result;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    host_thread_t* thread = osThreadGetId();
+    struct timespec deadline = host_deadline(timeout);
+    uint32_t result = (uint32_t)osFlagsErrorTimeout;
+
+    pthread_mutex_lock(&thread->lock);
+    for (;;) {
+        uint32_t matched = thread->flags & flags;
+        if ((options & osFlagsWaitAll) ? matched == flags : matched != 0) {
+            result = thread->flags;
+            if (!(options & osFlagsNoClear)) {
+                thread->flags &= ~flags;
+            }
+            break;
+        }
+        if (timeout == 0) {
+            result = (uint32_t)osFlagsErrorResource;
+            break;
+        }
+        if (timeout == osWaitForever) {
+            pthread_cond_wait(&thread->cond, &thread->lock);
+        } else if (pthread_cond_timedwait(&thread->cond, &thread->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&thread->lock);
+    return result;
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t* attr) {
+    pthread_mutex_t* mutex = malloc(sizeof(pthread_mutex_t));
+    if (mutex == NULL) {
+        return NULL;
+    }
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    if (attr != NULL && (attr->attr_bits & osMutexRecursive)) {
+        pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+    }
+    pthread_mutex_init(mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+    return mutex;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout) {
+    pthread_mutex_t* mutex = mutex_id;
+    if (mutex == NULL) {
+        return osErrorParameter;
+    }
+    if (timeout == osWaitForever) {
+        return (pthread_mutex_lock(mutex) == 0) ? osOK : osError;
+    }
+    if (timeout == 0) {
+        return (pthread_mutex_trylock(mutex) == 0) ? osOK : osErrorResource;
+    }
+    struct timespec deadline = host_deadline(timeout);
+    return (pthread_mutex_timedlock(mutex, &deadline) == 0) ? osOK : osErrorTimeout;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id) {
+    pthread_mutex_t* mutex = mutex_id;
+    if (mutex == NULL) {
+        return osErrorParameter;
+    }
+    return (pthread_mutex_unlock(mutex) == 0) ? osOK : osErrorResource;
+}
+
+static void* host_timer_entry(void* argument) {
+    host_timer_t* timer = argument;
+    do {
+        host_sleep_ms(timer->period * 1000 / HOST_TICK_FREQ);
+        timer->func(timer->argument);
+    } while (timer->type == osTimerPeriodic);
+    return NULL;
+}
+
+osTimerId_t osTimerNew(osTimerFunc_t func, osTimerType_t type, void* argument, const osTimerAttr_t* attr) {
+    host_timer_t* timer = calloc(1, sizeof(host_timer_t));
+    if (timer != NULL) {
+        timer->func = func;
+        timer->type = type;
+        timer->argument = argument;
+    }
+    return timer;
+}
+
+/**
+ * @note Timer runs until the process ends, it is not restarted or stopped on host
+ */
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks) {
+    host_timer_t* timer = timer_id;
+    if (timer == NULL || ticks == 0) {
+        return osErrorParameter;
+    }
+    if (timer->started) {
+        return osErrorResource;
+    }
+    timer->period = ticks;
+    if (pthread_create(&timer->thread, NULL, host_timer_entry, timer) != 0) {
+        return osErrorResource;
+    }
+    pthread_detach(timer->thread);
+    timer->started = true;
+    return osOK;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file gui_host.c
+ * @brief GUI on host, there is no screen, date and time count as configured and chart values are discarded
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "gui.h"
+
+void gui_init(void) {
+}
+
+void gui_process(void) {
+}
+
+bool gui_is_datetime_configured(void) {
+    return true;
+}
+
+void gui_history_init_data_source(const history_data_source_t* data_source) {
+}
+
+void gui_sensmon_update_current_value(sensor_data_type_t type, int32_t value) {
+}
+
+void gui_sensmon_push_chart_value(sensor_data_type_t type, int32_t value) {
+}
+
+void gui_sensmon_push_source_chart_value(sensor_data_type_t type, uint8_t lane, int32_t value) {
+}
@@ -0,0 +1,22 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in of FreeRTOS configuration, declares only what modules under test refer to
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define configTICK_RATE_HZ 1000
+#define configGENERATE_RUN_TIME_STATS 0
+
+typedef uint32_t StackType_t;
+
+/**
+ * @brief Control block memory handed to osThreadNew, host threads keep their state elsewhere
+ */
+typedef struct {
+    void* reserved[32];
+} StaticTask_t;
@@ -0,0 +1,14 @@
+/**
+ * @file lvgl.h
+ * @brief Host stand-in of graphics library header, declares only what GUI api and archivist refer to
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define LV_CHART_POINT_NONE INT16_MAX
+
+typedef struct _lv_obj_t lv_obj_t;
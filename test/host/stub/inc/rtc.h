@@ -0,0 +1,44 @@
+/**
+ * @file rtc.h
+ * @brief Host stand-in of RTC peripheral header, RTC follows host clock in UTC
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define RTC_FORMAT_BIN 0
+#define RTC_FORMAT_BCD 1
+
+typedef enum {
+    HAL_OK,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT,
+} HAL_StatusTypeDef;
+
+typedef struct {
+    uint8_t Hours;
+    uint8_t Minutes;
+    uint8_t Seconds;
+    uint32_t SubSeconds;        /**< Counts down from SecondFraction within every second */
+    uint32_t SecondFraction;
+} RTC_TimeTypeDef;
+
+typedef struct {
+    uint8_t WeekDay;
+    uint8_t Month;
+    uint8_t Date;
+    uint8_t Year;               /**< Years since 2000 */
+} RTC_DateTypeDef;
+
+typedef struct {
+    void* Instance;
+} RTC_HandleTypeDef;
+
+extern RTC_HandleTypeDef hrtc;
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* handle, RTC_TimeTypeDef* time, uint32_t format);
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef* handle, RTC_DateTypeDef* date, uint32_t format);
@@ -0,0 +1,10 @@
+/**
+ * @file task.h
+ * @brief Host stand-in of FreeRTOS task API, run-time statistics are not available on host
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
@@ -0,0 +1,8 @@
+/**
+ * @file usart.h
+ * @brief Host stand-in of UART peripheral header, host logger writes to stdout
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
@@ -0,0 +1,53 @@
+/**
+ * @file memory_ram.c
+ * @brief Flash memory driver on host, RAM model of NOR flash where erase sets bits and program clears them
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "memory.h"
+#include <string.h>
+
+#define MEMORY_RAM_SECTOR_SIZE 4096
+#define MEMORY_RAM_SECTORS 512
+#define MEMORY_RAM_ID 0xEF4019
+
+memory_driver_t memory;
+static uint8_t flash[MEMORY_RAM_SECTOR_SIZE * MEMORY_RAM_SECTORS];
+
+static bool memory_ram_init(void) {
+    memset(flash, 0xFF, sizeof(flash));
+    return true;
+}
+
+static void memory_ram_read(uint8_t* buf, uint32_t addr, uint32_t len) {
+    memcpy(buf, &flash[addr % sizeof(flash)], len);
+}
+
+static void memory_ram_write(const uint8_t* buf, uint32_t addr, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        flash[(addr + i) % sizeof(flash)] &= buf[i];
+    }
+}
+
+static void memory_ram_erase_sector(uint32_t addr) {
+    memset(&flash[(addr % sizeof(flash)) / MEMORY_RAM_SECTOR_SIZE * MEMORY_RAM_SECTOR_SIZE], 0xFF, MEMORY_RAM_SECTOR_SIZE);
+}
+
+static void memory_ram_erase_chip(void) {
+    memset(flash, 0xFF, sizeof(flash));
+}
+
+static uint32_t memory_ram_get_id(void) {
+    return MEMORY_RAM_ID;
+}
+
+void memory_init_driver(void) {
+    memory.init = memory_ram_init;
+    memory.read = memory_ram_read;
+    memory.write = memory_ram_write;
+    memory.erase_sector = memory_ram_erase_sector;
+    memory.erase_chip = memory_ram_erase_chip;
+    memory.get_id = memory_ram_get_id;
+    memory.sector_size = MEMORY_RAM_SECTOR_SIZE;
+}
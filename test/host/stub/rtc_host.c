@@ -0,0 +1,37 @@
+/**
+ * @file rtc_host.c
+ * @brief RTC on host clock, time and date are read at once in UTC
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "rtc.h"
+#include <time.h>
+
+#define HOST_RTC_SECOND_FRACTION 255
+
+RTC_HandleTypeDef hrtc;
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* handle, RTC_TimeTypeDef* time, uint32_t format) {
+    struct timespec now;
+    struct tm fields;
+    clock_gettime(CLOCK_REALTIME, &now);
+    gmtime_r(&now.tv_sec, &fields);
+    time->Hours = (uint8_t)fields.tm_hour;
+    time->Minutes = (uint8_t)fields.tm_min;
+    time->Seconds = (uint8_t)fields.tm_sec;
+    time->SecondFraction = HOST_RTC_SECOND_FRACTION;
+    time->SubSeconds = HOST_RTC_SECOND_FRACTION - (uint32_t)((uint64_t)now.tv_nsec * (HOST_RTC_SECOND_FRACTION + 1) / 1000000000);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef* handle, RTC_DateTypeDef* date, uint32_t format) {
+    time_t now = time(NULL);
+    struct tm fields;
+    gmtime_r(&now, &fields);
+    date->WeekDay = (uint8_t)((fields.tm_wday == 0) ? 7 : fields.tm_wday);
+    date->Month = (uint8_t)(fields.tm_mon + 1);
+    date->Date = (uint8_t)fields.tm_mday;
+    date->Year = (uint8_t)(fields.tm_year - 100);
+    return HAL_OK;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file slog_host.c
+ * @brief Serial logger on host, writes to stdout, debug messages are shown when SLOG_DEBUG is set in environment
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "slog.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void slog_write(slog_level_t level, const char* format, ...) {
+    static const char* const prefixes[] = {
+        [LOG_LEVEL_ERROR] = "ERROR",
+        [LOG_LEVEL_WARN] = "WARN",
+        [LOG_LEVEL_DEBUG] = "DEBUG",
+        [LOG_LEVEL_INFO] = "INFO",
+    };
+    if (level == LOG_LEVEL_DEBUG && getenv("SLOG_DEBUG") == NULL) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    flockfile(stdout);
+    printf("[%s] ", prefixes[level]);
+    vprintf(format, args);
+    putchar('\n');
+    funlockfile(stdout);
+    va_end(args);
+}
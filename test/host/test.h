@@ -0,0 +1,36 @@
+/**
+ * @file test.h
+ * @brief Minimal checks of host unit tests, every test is a separate executable failing on the first broken check
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CHECK(cond)                                                                \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);             \
+            exit(1);                                                                    \
+        }                                                                               \
+    } while (0)
+
+#define TEST_CHECK_EQ(actual, expected)                                                 \
+    do {                                                                                \
+        long long actual_ = (long long)(actual);                                        \
+        long long expected_ = (long long)(expected);                                    \
+        if (actual_ != expected_) {                                                     \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual,   \
+                actual_, expected_);                                                    \
+            exit(1);                                                                    \
+        }                                                                               \
+    } while (0)
+
+#define TEST_RUN(test)                  \
+    do {                                \
+        printf("-- %s\n", #test);       \
+        test();                         \
+    } while (0)
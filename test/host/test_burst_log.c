@@ -0,0 +1,85 @@
+/**
+ * @file test_burst_log.c
+ * @brief Burst log ring on RAM flash model, records read back newest first before and after wrap and reboot
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "burst_log.h"
+#include "memory.h"
+
+#define LOG_SECTORS 2
+#define CHUNK 8
+
+static uint32_t next_timestamp = 1;
+
+static uint32_t records_per_sector(void) {
+    return memory.sector_size / sizeof(burst_record_t);
+}
+
+static void append_records(uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, next_timestamp++) {
+        burst_record_t record = {.timestamp = next_timestamp, .count = 10, .mean = (int32_t)next_timestamp * 10};
+        burst_log_append(&record);
+    }
+}
+
+/**
+ * @brief Reads whole log in chunks, timestamps go down by one from the newest record
+ */
+static uint32_t check_records(void) {
+    burst_record_t records[CHUNK];
+    uint32_t total = 0;
+    uint16_t loaded;
+    while ((loaded = burst_log_read(total, records, CHUNK)) > 0) {
+        for (uint16_t i = 0; i < loaded; i++) {
+            uint32_t timestamp = next_timestamp - 1 - total;
+            TEST_CHECK_EQ(records[i].timestamp, timestamp);
+            TEST_CHECK_EQ(records[i].mean, (int32_t)timestamp * 10);
+            total++;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Empty log reads nothing, filled one reads every record
+ */
+static void test_read(void) {
+    burst_record_t record;
+    TEST_CHECK_EQ(burst_log_read(0, &record, 1), 0);
+    append_records(records_per_sector() + 3);
+    TEST_CHECK_EQ(check_records(), records_per_sector() + 3);
+}
+
+/**
+ * @brief Wrapped ring reads back to the oldest record left after the erased sector
+ */
+static void test_wrap(void) {
+    const uint32_t per_sector = records_per_sector();
+    append_records(2 * per_sector);
+    /* Sector being written holds 3 records, the other one the whole previous sector */
+    TEST_CHECK_EQ(check_records(), per_sector + 3);
+}
+
+/**
+ * @brief Log placed again after reboot continues after the newest record
+ */
+static void test_reboot(void) {
+    burst_log_init(0, memory.sector_size * LOG_SECTORS);
+    TEST_CHECK_EQ(check_records(), records_per_sector() + 3);
+    append_records(1);
+    TEST_CHECK_EQ(check_records(), records_per_sector() + 4);
+}
+
+int main(void) {
+    memory_init_driver();
+    memory.init();
+    burst_log_init(0, memory.sector_size * LOG_SECTORS);
+
+    TEST_RUN(test_read);
+    TEST_RUN(test_wrap);
+    TEST_RUN(test_reboot);
+    return 0;
+}
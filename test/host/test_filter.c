@@ -0,0 +1,181 @@
+/**
+ * @file test_filter.c
+ * @brief Bit-exact golden vectors of median, EMA and Kalman stages and of per-quantity chains,
+ *        cross-checked against floating-point reference models
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "filter.h"
+#include "monotime.h"
+#include <math.h>
+
+#define INPUT_COUNT (sizeof(input) / sizeof(input[0]))
+#define BENCHMARK_SAMPLES 100000
+
+/* Steady level, single spike, ramp, negative step and small noise */
+static const int32_t input[] = {
+    1000, 1000, 1000, 5000, 1000, 1000, 1200, 1400, 1600, 1800, 2000, 2000,
+    2000, -500, -500, -500, -500, 0, 3, 7, 2, 9, -4, 1,
+};
+
+static const int32_t golden_median3[] = {
+    1000, 1000, 1000, 1000, 1000, 1000, 1000, 1200, 1400, 1600, 1800, 2000,
+    2000, 2000, -500, -500, -500, -500, 0, 3, 3, 7, 2, 1,
+};
+
+static const int32_t golden_median5[] = {
+    1000, 1000, 1000, 1000, 1000, 1000, 1000, 1200, 1200, 1400, 1600, 1800,
+    2000, 2000, 2000, -500, -500, -500, -500, 0, 2, 3, 3, 2,
+};
+
+static const int32_t golden_ema[] = {
+    1000, 1000, 1000, 2000, 1750, 1563, 1472, 1454, 1490, 1568, 1676, 1757,
+    1818, 1238, 804, 478, 233, 175, 132, 101, 76, 59, 43, 33,
+};
+
+static const int32_t golden_kalman[] = {
+    1000, 1000, 1000, 2714, 1980, 1560, 1406, 1403, 1488, 1621, 1784, 1876,
+    1929, 888, 293, -47, -241, -138, -77, -41, -23, -9, -7, -4,
+};
+
+/* Configured chains, temperature and humidity share median 3 -> EMA 1/4 */
+static const int32_t golden_chain[SENSOR_TYPE_COUNT][INPUT_COUNT] = {
+    [SENSOR_TEMPERATURE] = {
+        1000, 1000, 1000, 1000, 1000, 1000, 1000, 1050, 1138, 1253, 1390, 1542,
+        1657, 1743, 1182, 761, 446, 210, 157, 119, 90, 69, 52, 39,
+    },
+    [SENSOR_HUMIDITY] = {
+        1000, 1000, 1000, 1000, 1000, 1000, 1000, 1050, 1138, 1253, 1390, 1542,
+        1657, 1743, 1182, 761, 446, 210, 157, 119, 90, 69, 52, 39,
+    },
+    [SENSOR_PRESSURE] = {
+        1000, 1000, 1000, 2714, 1980, 1560, 1406, 1403, 1488, 1621, 1784, 1876,
+        1929, 888, 293, -47, -241, -138, -77, -41, -23, -9, -7, -4,
+    },
+    [SENSOR_TVOC] = {
+        1000, 1000, 1000, 1000, 1000, 1000, 1000, 1100, 1150, 1275, 1438, 1619,
+        1809, 1905, 1952, 726, 113, -193, -347, -173, -86, -41, -19, -9,
+    },
+};
+
+static void check_golden(const filter_config_t* config, const int32_t* golden) {
+    filter_state_t state;
+    filter_reset(&state);
+    for (uint32_t i = 0; i < INPUT_COUNT; i++) {
+        int32_t output = filter_apply(&state, config, input[i]);
+        if (output != golden[i]) {
+            printf("sample %u\n", i);
+        }
+        TEST_CHECK_EQ(output, golden[i]);
+    }
+}
+
+static int32_t reference_median(uint32_t index, uint8_t window) {
+    uint8_t count = (index + 1 < window) ? index + 1 : window;
+    int32_t sorted[FILTER_MEDIAN_MAX];
+    for (uint8_t i = 0; i < count; i++) {
+        sorted[i] = input[index - i];
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        for (uint8_t j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+            int32_t tmp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = tmp;
+        }
+    }
+    return sorted[count / 2];
+}
+
+static void test_median(void) {
+    const filter_config_t median3 = {.median_n = 3};
+    const filter_config_t median5 = {.median_n = 5};
+    check_golden(&median3, golden_median3);
+    check_golden(&median5, golden_median5);
+    for (uint32_t i = 0; i < INPUT_COUNT; i++) {
+        TEST_CHECK_EQ(golden_median3[i], reference_median(i, 3));
+        TEST_CHECK_EQ(golden_median5[i], reference_median(i, 5));
+    }
+}
+
+static void test_ema(void) {
+    const filter_config_t ema = {.ema_alpha = FILTER_ONE / 4};
+    check_golden(&ema, golden_ema);
+
+    /* Fixed-point state keeps 16 fractional bits, output stays within rounding of the exact filter */
+    double reference = input[0];
+    for (uint32_t i = 0; i < INPUT_COUNT; i++) {
+        reference += (input[i] - reference) / 4;
+        TEST_CHECK(fabs(golden_ema[i] - reference) <= 0.5 + 1e-3);
+    }
+}
+
+static void test_kalman(void) {
+    const filter_config_t kalman = {.kalman = true, .kalman_q = 1, .kalman_r = 4};
+    check_golden(&kalman, golden_kalman);
+
+    /* Variance is kept in whole value units by design, reference estimate is exact on top of it */
+    double estimate = input[0];
+    uint32_t variance = kalman.kalman_r;
+    for (uint32_t i = 0; i < INPUT_COUNT; i++) {
+        uint32_t predicted = variance + kalman.kalman_q;
+        uint32_t gain = (uint32_t)(((uint64_t)predicted << FILTER_FRAC_BITS) / (predicted + kalman.kalman_r));
+        estimate += (input[i] - estimate) * gain / FILTER_ONE;
+        variance = predicted - (uint32_t)(((uint64_t)predicted * gain) >> FILTER_FRAC_BITS);
+        TEST_CHECK(fabs(golden_kalman[i] - estimate) <= 0.5 + 1e-3);
+    }
+}
+
+static void test_configured_chains(void) {
+    for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        check_golden(filter_get_config(type), golden_chain[type]);
+    }
+}
+
+static void test_reset(void) {
+    const filter_config_t ema = {.ema_alpha = FILTER_ONE / 4};
+    filter_state_t state;
+    filter_reset(&state);
+    filter_apply(&state, &ema, 1000);
+    TEST_CHECK_EQ(filter_apply(&state, &ema, 2000), 1250);
+    filter_reset(&state);
+    TEST_CHECK_EQ(filter_apply(&state, &ema, 2000), 2000);
+}
+
+static void test_extremes(void) {
+    const filter_config_t kalman = {.kalman = true, .kalman_q = UINT32_MAX, .kalman_r = 1};
+    filter_state_t state;
+    filter_reset(&state);
+    TEST_CHECK_EQ(filter_apply(&state, &kalman, INT32_MAX), INT32_MAX);
+    /* Saturated variance gives gain of one less an LSB, full range step does not overflow the estimate */
+    int32_t estimate = filter_apply(&state, &kalman, INT32_MIN);
+    TEST_CHECK(estimate >= INT32_MIN && estimate <= INT32_MIN + (int32_t)((1ULL << 32) / FILTER_ONE));
+    for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        filter_reset(&state);
+        for (uint8_t i = 0; i < FILTER_MEDIAN_MAX; i++) {
+            TEST_CHECK_EQ(filter_apply(&state, filter_get_config(type), INT32_MIN), INT32_MIN);
+        }
+    }
+}
+
+static void test_benchmark(void) {
+    for (sensor_data_type_t type = 0; type < SENSOR_TYPE_COUNT; type++) {
+        uint32_t cycles = filter_measure_cycles(type, BENCHMARK_SAMPLES);
+        printf("type %d: %u ns per sample\n", type, cycles);
+        TEST_CHECK(cycles > 0);
+    }
+}
+
+int main(void) {
+    monotime_init();
+
+    TEST_RUN(test_median);
+    TEST_RUN(test_ema);
+    TEST_RUN(test_kalman);
+    TEST_RUN(test_configured_chains);
+    TEST_RUN(test_reset);
+    TEST_RUN(test_extremes);
+    TEST_RUN(test_benchmark);
+    return 0;
+}
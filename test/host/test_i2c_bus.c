@@ -0,0 +1,237 @@
+/**
+ * @file test_i2c_bus.c
+ * @brief Transaction layer on simulated bus, timed out and aborted transfers, priority and accounting of bus grants
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "i2c_bus.h"
+#include "i2c_sim.h"
+#include "cmsis_os2.h"
+#include <pthread.h>
+
+#define TEST_BUS I2C_BUS_TOUCH
+#define RECORDER_ADDR 0x10
+#define GATE_ADDR 0x11
+#define STALL_ADDR 0x12
+#define SHORT_TIMEOUT_MS 20
+#define LONG_TIMEOUT_MS 1000
+#define MAX_RECORDS 8
+
+/**
+ * @brief Queued requester, transmits its id to the recorder once granted
+ */
+typedef struct {
+    i2c_priority_t priority;
+    uint8_t id;
+    uint32_t timeout_ms;
+    i2c_status_t status;
+} requester_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static bool gate_entered;
+static bool gate_open = true;
+static uint8_t records[MAX_RECORDS];
+static uint8_t record_count;
+static uint32_t aborts;
+static void (*sim_abort)(i2c_bus_id_t bus);
+
+static void recorder_write(i2c_sim_device_t* device, const uint8_t* data, uint16_t len) {
+    pthread_mutex_lock(&lock);
+    if (len > 0 && record_count < MAX_RECORDS) {
+        records[record_count++] = data[0];
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void device_read(i2c_sim_device_t* device, uint8_t* data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = 0;
+    }
+}
+
+/**
+ * @brief Holds the bus within transfer until the gate is opened
+ */
+static void gate_write(i2c_sim_device_t* device, const uint8_t* data, uint16_t len) {
+    pthread_mutex_lock(&lock);
+    gate_entered = true;
+    pthread_cond_broadcast(&gate_cond);
+    while (!gate_open) {
+        pthread_cond_wait(&gate_cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static i2c_sim_device_t recorder = {.bus = TEST_BUS, .addr = RECORDER_ADDR, .write = recorder_write, .read = device_read, .attached = true};
+static i2c_sim_device_t gate = {.bus = TEST_BUS, .addr = GATE_ADDR, .write = gate_write, .read = device_read, .attached = true};
+static i2c_sim_device_t staller = {
+    .bus = TEST_BUS, .addr = STALL_ADDR, .write = recorder_write, .read = device_read, .attached = true, .faults = {.stall_every = 1},
+};
+
+static void counting_abort(i2c_bus_id_t bus) {
+    aborts++;
+    sim_abort(bus);
+}
+
+static void* gate_holder(void* argument) {
+    uint8_t id = 0;
+    i2c_bus_transmit(TEST_BUS, I2C_PRIORITY_LOW, GATE_ADDR, &id, 1);
+    return NULL;
+}
+
+static void* requester_task(void* argument) {
+    requester_t* requester = argument;
+    i2c_transaction_t transaction = {
+        .bus = TEST_BUS, .priority = requester->priority, .op = I2C_OP_TRANSMIT, .addr = RECORDER_ADDR,
+        .data = &requester->id, .len = 1, .timeout_ms = requester->timeout_ms,
+    };
+    requester->status = i2c_bus_transfer(&transaction);
+    return NULL;
+}
+
+/**
+ * @brief Starts a transfer that keeps the bus until gate_release()
+ */
+static void gate_hold(pthread_t* holder) {
+    pthread_mutex_lock(&lock);
+    gate_open = false;
+    gate_entered = false;
+    pthread_mutex_unlock(&lock);
+    TEST_CHECK_EQ(pthread_create(holder, NULL, gate_holder, NULL), 0);
+    pthread_mutex_lock(&lock);
+    while (!gate_entered) {
+        pthread_cond_wait(&gate_cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void gate_release(pthread_t holder) {
+    pthread_mutex_lock(&lock);
+    gate_open = true;
+    pthread_cond_broadcast(&gate_cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(holder, NULL);
+}
+
+static void wait_queue_depth(uint8_t depth) {
+    i2c_bus_stats_t stats;
+    do {
+        osDelay(1);
+        i2c_bus_get_stats(TEST_BUS, &stats);
+    } while (stats.queue_depth != depth);
+}
+
+/**
+ * @brief Transfer that never completes times out, the bus is aborted and serves the next transfer
+ */
+static void test_timeout(void) {
+    uint8_t data[2];
+    i2c_transaction_t transaction = {
+        .bus = TEST_BUS, .priority = I2C_PRIORITY_NORMAL, .op = I2C_OP_RECEIVE, .addr = STALL_ADDR,
+        .data = data, .len = sizeof(data), .timeout_ms = SHORT_TIMEOUT_MS,
+    };
+    i2c_bus_stats_t stats;
+    uint32_t start = osKernelGetTickCount();
+    TEST_CHECK_EQ(i2c_bus_transfer(&transaction), I2C_STATUS_TIMEOUT);
+    TEST_CHECK(osKernelGetTickCount() - start >= SHORT_TIMEOUT_MS);
+    TEST_CHECK_EQ(aborts, 1);
+    TEST_CHECK_EQ(i2c_bus_last_status(TEST_BUS), I2C_STATUS_TIMEOUT);
+
+    /* Completion arriving after the abort has nobody to wake and does not leak into the next transfer */
+    i2c_bus_complete_handler(TEST_BUS, false);
+    uint8_t id = 0;
+    TEST_CHECK_EQ(i2c_bus_transmit(TEST_BUS, I2C_PRIORITY_NORMAL, RECORDER_ADDR, &id, 1), I2C_STATUS_OK);
+    i2c_bus_get_stats(TEST_BUS, &stats);
+    TEST_CHECK_EQ(stats.transactions, 2);
+    TEST_CHECK_EQ(stats.failures, 1);
+    TEST_CHECK_EQ(stats.queue_depth, 0);
+}
+
+/**
+ * @brief Requester not granted within its timeout gives up and leaves the queue
+ */
+static void test_queue_abort(void) {
+    pthread_t holder;
+    pthread_t thread;
+    requester_t requester = {.priority = I2C_PRIORITY_HIGH, .id = 0, .timeout_ms = SHORT_TIMEOUT_MS};
+    gate_hold(&holder);
+    TEST_CHECK_EQ(pthread_create(&thread, NULL, requester_task, &requester), 0);
+    pthread_join(thread, NULL);
+    TEST_CHECK_EQ(requester.status, I2C_STATUS_BUSY);
+    wait_queue_depth(0);
+    gate_release(holder);
+}
+
+/**
+ * @brief Bus goes to the most urgent queued requester, equal ones are served in order of arrival
+ */
+static void test_priority_order(void) {
+    requester_t requesters[] = {
+        {.priority = I2C_PRIORITY_LOW, .id = 1, .timeout_ms = LONG_TIMEOUT_MS},
+        {.priority = I2C_PRIORITY_NORMAL, .id = 2, .timeout_ms = LONG_TIMEOUT_MS},
+        {.priority = I2C_PRIORITY_HIGH, .id = 3, .timeout_ms = LONG_TIMEOUT_MS},
+        {.priority = I2C_PRIORITY_NORMAL, .id = 4, .timeout_ms = LONG_TIMEOUT_MS},
+    };
+    const uint8_t expected[] = {3, 2, 4, 1};
+    const uint8_t count = sizeof(requesters) / sizeof(requesters[0]);
+    pthread_t threads[sizeof(requesters) / sizeof(requesters[0])];
+    pthread_t holder;
+    i2c_bus_stats_t before;
+    i2c_bus_stats_t after;
+
+    i2c_bus_get_stats(TEST_BUS, &before);
+    record_count = 0;
+    gate_hold(&holder);
+    for (uint8_t i = 0; i < count; i++) {
+        TEST_CHECK_EQ(pthread_create(&threads[i], NULL, requester_task, &requesters[i]), 0);
+        wait_queue_depth(i + 1);
+    }
+    gate_release(holder);
+    for (uint8_t i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+        TEST_CHECK_EQ(requesters[i].status, I2C_STATUS_OK);
+    }
+
+    TEST_CHECK_EQ(record_count, count);
+    for (uint8_t i = 0; i < count; i++) {
+        TEST_CHECK_EQ(records[i], expected[i]);
+    }
+    /* Every grant but the last one went ahead of the low priority requester queued first */
+    i2c_bus_get_stats(TEST_BUS, &after);
+    TEST_CHECK_EQ(after.overtakes - before.overtakes, count - 1);
+    TEST_CHECK_EQ(after.queue_max, count);
+    /* Holder and every requester waited for one grant each */
+    TEST_CHECK_EQ(after.grants - before.grants, count + 1);
+    TEST_CHECK_EQ(after.transactions - before.transactions, count + 1);
+}
+
+/**
+ * @brief Probe is granted the bus like a transfer, its wait is averaged over grants and not over transactions
+ */
+static void test_probe_grant(void) {
+    i2c_bus_stats_t before;
+    i2c_bus_stats_t after;
+    i2c_bus_get_stats(TEST_BUS, &before);
+    TEST_CHECK(i2c_bus_probe(TEST_BUS, RECORDER_ADDR, 1));
+    i2c_bus_get_stats(TEST_BUS, &after);
+    TEST_CHECK_EQ(after.grants - before.grants, 1);
+    TEST_CHECK_EQ(after.transactions, before.transactions);
+}
+
+int main(void) {
+    i2c_bus_init();
+    sim_abort = i2c_bus.abort;
+    i2c_bus.abort = counting_abort;
+    i2c_sim_add_device(&recorder);
+    i2c_sim_add_device(&gate);
+    i2c_sim_add_device(&staller);
+
+    TEST_RUN(test_timeout);
+    TEST_RUN(test_queue_abort);
+    TEST_RUN(test_priority_order);
+    TEST_RUN(test_probe_grant);
+    return 0;
+}
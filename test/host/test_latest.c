@@ -0,0 +1,114 @@
+/**
+ * @file test_latest.c
+ * @brief Latest value seqlock under one writer and concurrent readers, snapshots shall never be torn
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "latest.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define READERS 3
+#define WRITES 2000000
+
+/* Timestamp derived from value, spans both halves of 64-bit field so that torn reads show up */
+#define STAMP_OF(value) ((uint64_t)(uint32_t)(value) * 0x100000001ULL)
+
+typedef struct {
+    uint32_t consistent;
+    uint32_t retried_out;
+    uint32_t torn;
+    uint32_t backwards;
+} reader_stats_t;
+
+static atomic_bool writer_done;
+
+static void* writer(void* argument) {
+    for (int32_t value = 1; value <= WRITES; value++) {
+        latest_write(SENSOR_HUMIDITY, SENSOR_SOURCE_AHT20, value, STAMP_OF(value));
+    }
+    atomic_store(&writer_done, true);
+    return NULL;
+}
+
+static void* reader(void* argument) {
+    reader_stats_t* stats = argument;
+    int32_t last = 0;
+    while (!atomic_load(&writer_done)) {
+        latest_value_t latest;
+        if (!latest_read(SENSOR_HUMIDITY, SENSOR_SOURCE_AHT20, &latest)) {
+            stats->retried_out++;
+            continue;
+        }
+        if (latest.quality == SAMPLE_QUALITY_NONE && latest.value == 0) {
+            /* Writer has not started yet */
+            continue;
+        }
+        stats->consistent++;
+        if (latest.timestamp_us != STAMP_OF(latest.value) || latest.quality != SAMPLE_QUALITY_GOOD) {
+            stats->torn++;
+        }
+        if (latest.value < last) {
+            stats->backwards++;
+        }
+        last = latest.value;
+    }
+    return NULL;
+}
+
+static void test_single_thread(void) {
+    latest_value_t latest;
+    TEST_CHECK(latest_read(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, &latest));
+    TEST_CHECK_EQ(latest.quality, SAMPLE_QUALITY_NONE);
+
+    /* Quality of channels without value stays none */
+    latest_set_source_quality(SENSOR_SOURCE_BMP280, SAMPLE_QUALITY_FAILED);
+    TEST_CHECK(latest_read(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, &latest));
+    TEST_CHECK_EQ(latest.quality, SAMPLE_QUALITY_NONE);
+
+    latest_write(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, 2150, 123456789ULL);
+    TEST_CHECK(latest_read(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, &latest));
+    TEST_CHECK_EQ(latest.value, 2150);
+    TEST_CHECK_EQ(latest.timestamp_us, 123456789ULL);
+    TEST_CHECK_EQ(latest.quality, SAMPLE_QUALITY_GOOD);
+
+    latest_set_source_quality(SENSOR_SOURCE_BMP280, SAMPLE_QUALITY_FAILED);
+    TEST_CHECK(latest_read(SENSOR_TEMPERATURE, SENSOR_SOURCE_BMP280, &latest));
+    TEST_CHECK_EQ(latest.value, 2150);
+    TEST_CHECK_EQ(latest.quality, SAMPLE_QUALITY_FAILED);
+}
+
+static void test_concurrent_readers(void) {
+    pthread_t writer_thread;
+    pthread_t reader_threads[READERS];
+    reader_stats_t stats[READERS] = {0};
+    uint32_t consistent = 0;
+
+    for (uint8_t i = 0; i < READERS; i++) {
+        TEST_CHECK_EQ(pthread_create(&reader_threads[i], NULL, reader, &stats[i]), 0);
+    }
+    TEST_CHECK_EQ(pthread_create(&writer_thread, NULL, writer, NULL), 0);
+    pthread_join(writer_thread, NULL);
+    for (uint8_t i = 0; i < READERS; i++) {
+        pthread_join(reader_threads[i], NULL);
+        printf("reader %u: consistent %u retried out %u torn %u backwards %u\n", i, stats[i].consistent,
+            stats[i].retried_out, stats[i].torn, stats[i].backwards);
+        TEST_CHECK_EQ(stats[i].torn, 0);
+        TEST_CHECK_EQ(stats[i].backwards, 0);
+        consistent += stats[i].consistent;
+    }
+    TEST_CHECK(consistent > 0);
+
+    latest_value_t latest;
+    TEST_CHECK(latest_read(SENSOR_HUMIDITY, SENSOR_SOURCE_AHT20, &latest));
+    TEST_CHECK_EQ(latest.value, WRITES);
+    TEST_CHECK_EQ(latest.timestamp_us, STAMP_OF(WRITES));
+}
+
+int main(void) {
+    TEST_RUN(test_single_thread);
+    TEST_RUN(test_concurrent_readers);
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_loadgen.c
+ * @brief Synthetic load through sample bus and archivist on RAM flash model, drops, lag and stored bytes
+ *        follow channel count
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "loadgen.h"
+#include "memory.h"
+#include "monotime.h"
+#include "cmsis_os2.h"
+#include <stdlib.h>
+
+#define FEW_CHANNELS 2
+#define MANY_CHANNELS LOADGEN_MAX_CHANNELS
+#define RATE_HZ "200"
+#define STEP_MS "1500"
+#define STEP_SAVES 2        /**< Saves that may fall within a step */
+
+void archivist_task(void* argument);
+
+/**
+ * @brief Waits until archivist has taken every sample left on the bus
+ */
+static void drain(sample_bus_stats_t* bus, archivist_stats_t* archivist) {
+    do {
+        osDelay(10);
+        sample_bus_get_stats(bus);
+    } while (bus->pending > 0);
+    archivist_get_stats(archivist);
+}
+
+/**
+ * @brief Runs one step, every published sample is either taken by archivist or dropped by the bus
+ */
+static void run_step(uint16_t channels, loadgen_result_t* result) {
+    sample_bus_stats_t bus_before;
+    sample_bus_stats_t bus_after;
+    archivist_stats_t archivist_before;
+    archivist_stats_t archivist_after;
+    drain(&bus_before, &archivist_before);
+    loadgen_step(channels, result);
+    drain(&bus_after, &archivist_after);
+
+    uint32_t published = bus_after.published - bus_before.published;
+    uint32_t received = archivist_after.received - archivist_before.received;
+    TEST_CHECK(result->generated > 0);
+    TEST_CHECK_EQ(published, result->generated);
+    TEST_CHECK_EQ(received + bus_after.dropped - bus_before.dropped, published);
+    TEST_CHECK_EQ(archivist_after.filtered - archivist_before.filtered, received);
+    TEST_CHECK_EQ(archivist_after.unrouted, archivist_before.unrouted);
+}
+
+/**
+ * @brief Few channels are taken without drops, one entry per channel and save is stored
+ */
+static void test_few_channels(void) {
+    loadgen_result_t result;
+    run_step(FEW_CHANNELS, &result);
+    TEST_CHECK_EQ(result.bus.dropped, 0);
+    TEST_CHECK(result.bus.max_lag < SAMPLE_BUS_SIZE);
+    TEST_CHECK(result.archivist.stored >= FEW_CHANNELS);
+    TEST_CHECK(result.payload_bytes <= STEP_SAVES * FEW_CHANNELS * sizeof(memory_entry_t));
+}
+
+/**
+ * @brief Channels beyond what archivist drains between its polls overflow the bus, stored data grows with channels
+ */
+static void test_many_channels(void) {
+    loadgen_result_t result;
+    run_step(MANY_CHANNELS, &result);
+    TEST_CHECK(result.bus.dropped > 0);
+    TEST_CHECK(result.bus.max_lag > SAMPLE_BUS_SIZE);
+    TEST_CHECK(result.archivist.stored >= MANY_CHANNELS);
+    TEST_CHECK(result.payload_bytes >= MANY_CHANNELS * sizeof(memory_entry_t));
+    TEST_CHECK(result.program_bytes >= result.payload_bytes);
+}
+
+int main(void) {
+    monotime_init();
+    setenv("LOADGEN_CHANNELS", "64", 1);
+    setenv("LOADGEN_RATE_HZ", RATE_HZ, 1);
+    setenv("LOADGEN_STEP_MS", STEP_MS, 1);
+    TEST_CHECK(osThreadNew(archivist_task, NULL, NULL) != NULL);
+    /* Archivist selects synthetic load right before it starts its timers */
+    while (!loadgen_is_active()) {
+        osDelay(10);
+    }
+    osDelay(100);
+
+    TEST_RUN(test_few_channels);
+    TEST_RUN(test_many_channels);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file test_replay.c
+ * @brief Replay of recorded file, samples keep recorded timeline whatever the replay speed is
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "replay.h"
+#include "sample_bus.h"
+#include "latest.h"
+#include "monotime.h"
+#include "cmsis_os2.h"
+#include <stdlib.h>
+
+#define REPLAY_PATH "replay_test.csv"
+#define REPLAY_TEST_SPEED 100
+
+static const char recording[] =
+    "time_ms,type,source,value,count,min,max\n"
+    "1000,0,0,2150\n"
+    "2000,1,0,4520\n"
+    "61000,2,1,101325\n"
+    "60000,0,0,2160\n"
+    "121000,3,2,120,8,100,180\n"
+    "121000,9,0,1\n";
+
+/* Out of order record is published at the latest recorded time, unknown type is skipped */
+static const uint32_t expected_offsets_ms[] = {0, 1000, 60000, 60000, 120000};
+
+static void test_recorded_timeline(void) {
+    FILE* file = fopen(REPLAY_PATH, "w");
+    TEST_CHECK(file != NULL);
+    fputs(recording, file);
+    fclose(file);
+    setenv("REPLAY_FILE", REPLAY_PATH, 1);
+    setenv("REPLAY_SPEED", "100", 1);
+
+    sample_bus_subscriber_t* samples = sample_bus_subscribe("replay test");
+    TEST_CHECK(replay_init());
+    TEST_CHECK(replay_is_active());
+    uint32_t start = osKernelGetTickCount();
+    replay_run();
+    uint32_t elapsed = osKernelGetTickCount() - start;
+    remove(REPLAY_PATH);
+
+    /* Two minutes of recording take at least 1.2 s at speed 100, a loaded host may only add to it */
+    TEST_CHECK(elapsed >= 120000 / REPLAY_TEST_SPEED);
+
+    const sensor_sample_t* sample;
+    uint64_t first_us = 0;
+    uint32_t count = 0;
+    while ((sample = sample_bus_peek(samples)) != NULL) {
+        sensor_sample_t copy = *sample;
+        TEST_CHECK(sample_bus_release(samples));
+        TEST_CHECK(count < sizeof(expected_offsets_ms) / sizeof(expected_offsets_ms[0]));
+        if (count == 0) {
+            first_us = copy.timestamp_us;
+        }
+        TEST_CHECK_EQ(copy.timestamp_us - first_us, (uint64_t)expected_offsets_ms[count] * 1000);
+        count++;
+    }
+    TEST_CHECK_EQ(count, sizeof(expected_offsets_ms) / sizeof(expected_offsets_ms[0]));
+
+    /* Recorded timeline runs ahead of real time */
+    latest_value_t latest;
+    TEST_CHECK(latest_read(SENSOR_TVOC, SENSOR_SOURCE_AGS02MA, &latest));
+    TEST_CHECK_EQ(latest.value, 120);
+    TEST_CHECK(latest.timestamp_us > monotime_now_us());
+}
+
+int main(void) {
+    monotime_init();
+
+    TEST_RUN(test_recorded_timeline);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file test_rollup.c
+ * @brief Compaction of raw entries into rollup buckets across sector reclaim and reboot
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "rollup.h"
+#include "memory.h"
+
+#define LOG_SECTORS 2
+#define MIN_AGE_S 100
+#define BUCKET_S 100
+#define STEP_ENTRIES 16
+#define CHUNK 16
+
+static tslog_t raw;
+static tslog_t rollup;
+static rollup_job_t job;
+static uint32_t next_timestamp = 1;
+
+/**
+ * @brief Appends raw entries one per second, the value is ten times the timestamp, and compacts as archivist does
+ */
+static void append_until(uint32_t last) {
+    for (; next_timestamp <= last; next_timestamp++) {
+        memory_entry_t entry = {.timestamp = next_timestamp, .value = (int32_t)next_timestamp * 10};
+        rollup_job_before_append(&job, next_timestamp);
+        tslog_append(&raw, &entry);
+        rollup_job_step(&job, next_timestamp, STEP_ENTRIES);
+    }
+}
+
+/**
+ * @brief Walks rollup log, every bucket is stored once, whole and in order
+ */
+static uint32_t check_buckets(void) {
+    static tslog_cursor_t cursor;
+    int32_t values[CHUNK];
+    uint32_t timestamps[CHUNK];
+    uint32_t total = 0;
+    uint16_t loaded;
+    tslog_cursor_init(&cursor, &rollup);
+    tslog_cursor_rewind(&cursor);
+    while ((loaded = tslog_cursor_next(&cursor, values, timestamps, CHUNK)) > 0) {
+        for (uint16_t i = 0; i < loaded; i++) {
+            /* The first bucket starts at the first timestamp, the others hold every second of their period */
+            uint32_t first = (total == 0) ? 1 : total * BUCKET_S;
+            uint32_t last = (total + 1) * BUCKET_S - 1;
+            TEST_CHECK_EQ(timestamps[i], total * BUCKET_S);
+            TEST_CHECK_EQ(values[i], (int32_t)(first + last) * 10 / 2);
+            total++;
+        }
+    }
+    return total;
+}
+
+static uint32_t entries_per_sector(void) {
+    return memory.sector_size / sizeof(memory_entry_t);
+}
+
+/**
+ * @brief Bucket whose raw entries span a reclaimed sector is stored as one entry
+ */
+static void test_bucket_across_reclaim(void) {
+    const uint32_t per_sector = entries_per_sector();
+    /* Bucket boundaries do not fall on sector boundaries */
+    TEST_CHECK(per_sector % BUCKET_S != 0);
+    append_until(3 * per_sector);
+    TEST_CHECK_EQ(check_buckets(), (3 * per_sector - MIN_AGE_S) / BUCKET_S);
+}
+
+/**
+ * @brief Job reinitialized after reboot continues after the newest bucket, compacted entries are not stored again
+ */
+static void test_resume_after_reboot(void) {
+    const uint32_t per_sector = entries_per_sector();
+    tslog_init(&raw, 0, memory.sector_size * LOG_SECTORS);
+    tslog_init(&rollup, memory.sector_size * LOG_SECTORS, memory.sector_size * LOG_SECTORS);
+    tslog_scan(&raw);
+    tslog_scan(&rollup);
+    rollup_job_init(&job, &raw, &rollup, MIN_AGE_S, BUCKET_S);
+
+    append_until(4 * per_sector);
+    TEST_CHECK_EQ(check_buckets(), (4 * per_sector - MIN_AGE_S) / BUCKET_S);
+}
+
+int main(void) {
+    memory_init_driver();
+    memory.init();
+    tslog_init(&raw, 0, memory.sector_size * LOG_SECTORS);
+    tslog_init(&rollup, memory.sector_size * LOG_SECTORS, memory.sector_size * LOG_SECTORS);
+    rollup_job_init(&job, &raw, &rollup, MIN_AGE_S, BUCKET_S);
+
+    TEST_RUN(test_bucket_across_reclaim);
+    TEST_RUN(test_resume_after_reboot);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file test_sample_bus.c
+ * @brief Sample bus delivery order, lap detection of slow readers and accounting of dropped samples
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "sample_bus.h"
+#include <pthread.h>
+
+#define PRODUCERS 2
+#define PRODUCER_SAMPLES 20000
+
+static sample_bus_subscriber_t* first;
+static sample_bus_subscriber_t* late;
+static int32_t next_value;
+static uint32_t published;
+static uint32_t published_before_late;
+
+static void publish(uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        sensor_sample_t sample = {.type = SENSOR_TEMPERATURE, .source = SENSOR_SOURCE_AHT20, .value = next_value++, .count = 1};
+        sample_bus_publish(&sample);
+        published++;
+    }
+}
+
+/**
+ * @brief Reads every pending sample, checks that intact ones come in publish order
+ *
+ * @return number of intact samples
+ */
+static uint32_t drain(sample_bus_subscriber_t* subscriber, int32_t* first_value) {
+    const sensor_sample_t* sample;
+    uint32_t intact = 0;
+    int32_t expected = 0;
+    while ((sample = sample_bus_peek(subscriber)) != NULL) {
+        int32_t value = sample->value;
+        if (!sample_bus_release(subscriber)) {
+            continue;
+        }
+        if (intact == 0 && first_value != NULL) {
+            *first_value = value;
+        } else if (intact > 0) {
+            TEST_CHECK_EQ(value, expected);
+        }
+        expected = value + 1;
+        intact++;
+    }
+    return intact;
+}
+
+static void test_publish_order(void) {
+    int32_t value;
+    TEST_CHECK(sample_bus_peek(first) == NULL);
+    publish(5);
+    TEST_CHECK_EQ(drain(first, &value), 5);
+    TEST_CHECK_EQ(value, 0);
+    TEST_CHECK_EQ(first->received, 5);
+    TEST_CHECK_EQ(first->dropped, 0);
+    TEST_CHECK_EQ(first->max_lag, 5);
+}
+
+static void test_peek_in_place(void) {
+    publish(1);
+    const sensor_sample_t* peeked = sample_bus_peek(first);
+    TEST_CHECK(peeked != NULL);
+    /* Peek does not consume, the same slot is returned until release */
+    TEST_CHECK(sample_bus_peek(first) == peeked);
+    TEST_CHECK_EQ(peeked->value, next_value - 1);
+    TEST_CHECK(sample_bus_release(first));
+    TEST_CHECK(sample_bus_peek(first) == NULL);
+}
+
+static void test_late_subscriber(void) {
+    int32_t value;
+    publish(3);
+    published_before_late = published;
+    late = sample_bus_subscribe("late");
+    TEST_CHECK(late != NULL);
+    TEST_CHECK(sample_bus_peek(late) == NULL);
+    publish(2);
+    TEST_CHECK_EQ(drain(late, &value), 2);
+    TEST_CHECK_EQ(value, next_value - 2);
+    TEST_CHECK_EQ(drain(first, NULL), 5);
+}
+
+static void test_overflow_drops(void) {
+    int32_t value;
+    uint32_t dropped = first->dropped;
+    publish(SAMPLE_BUS_SIZE + 10);
+    /* Reader continues from the oldest sample left in ring */
+    TEST_CHECK_EQ(drain(first, &value), SAMPLE_BUS_SIZE);
+    TEST_CHECK_EQ(value, next_value - SAMPLE_BUS_SIZE);
+    TEST_CHECK_EQ(first->dropped - dropped, 10);
+    TEST_CHECK_EQ(first->max_lag, SAMPLE_BUS_SIZE + 10);
+    drain(late, NULL);
+}
+
+static void test_lapped_read(void) {
+    uint32_t dropped = first->dropped;
+    publish(1);
+    const sensor_sample_t* peeked = sample_bus_peek(first);
+    TEST_CHECK(peeked != NULL);
+    /* Producer laps the reader while the sample is being read, its slot is reused */
+    publish(SAMPLE_BUS_SIZE);
+    TEST_CHECK(!sample_bus_release(first));
+    TEST_CHECK_EQ(first->dropped - dropped, 1);
+    TEST_CHECK_EQ(drain(first, NULL), SAMPLE_BUS_SIZE);
+    drain(late, NULL);
+}
+
+static void* producer(void* argument) {
+    for (uint32_t i = 0; i < PRODUCER_SAMPLES; i++) {
+        sensor_sample_t sample = {.type = SENSOR_PRESSURE, .source = (sensor_source_t)(uintptr_t)argument, .value = (int32_t)i};
+        sample_bus_publish(&sample);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Producers of several buses publish concurrently, every sample is either received or dropped
+ */
+static void test_concurrent_producers(void) {
+    pthread_t threads[PRODUCERS];
+    uint32_t received = late->received;
+    uint32_t dropped = late->dropped;
+    int32_t last[PRODUCERS] = {-1, -1};
+
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        TEST_CHECK_EQ(pthread_create(&threads[i], NULL, producer, (void*)i), 0);
+    }
+    for (uint8_t i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    published += PRODUCERS * PRODUCER_SAMPLES;
+
+    const sensor_sample_t* sample;
+    while ((sample = sample_bus_peek(late)) != NULL) {
+        sensor_sample_t copy = *sample;
+        if (!sample_bus_release(late)) {
+            continue;
+        }
+        TEST_CHECK(copy.source < PRODUCERS);
+        /* Samples of one producer keep their order */
+        TEST_CHECK(copy.value > last[copy.source]);
+        last[copy.source] = copy.value;
+    }
+    TEST_CHECK_EQ((late->received - received) + (late->dropped - dropped), PRODUCERS * PRODUCER_SAMPLES);
+    TEST_CHECK_EQ(late->received - received, SAMPLE_BUS_SIZE);
+    drain(first, NULL);
+}
+
+static void test_stats(void) {
+    sample_bus_stats_t stats;
+    publish(3);
+    sample_bus_get_stats(&stats);
+    TEST_CHECK_EQ(stats.published, published);
+    TEST_CHECK_EQ(stats.pending, 3);
+    /* Every sample published since subscription is received, dropped or pending */
+    TEST_CHECK_EQ(stats.received + stats.dropped, (published - 3) + (published - published_before_late - 3));
+    TEST_CHECK_EQ(stats.max_lag, PRODUCERS * PRODUCER_SAMPLES);
+}
+
+static void test_subscriber_limit(void) {
+    for (uint8_t i = 2; i < SAMPLE_BUS_MAX_SUBSCRIBERS; i++) {
+        TEST_CHECK(sample_bus_subscribe("extra") != NULL);
+    }
+    TEST_CHECK(sample_bus_subscribe("overflow") == NULL);
+}
+
+int main(void) {
+    first = sample_bus_subscribe("first");
+    TEST_CHECK(first != NULL);
+
+    TEST_RUN(test_publish_order);
+    TEST_RUN(test_peek_in_place);
+    TEST_RUN(test_late_subscriber);
+    TEST_RUN(test_overflow_drops);
+    TEST_RUN(test_lapped_read);
+    TEST_RUN(test_concurrent_producers);
+    TEST_RUN(test_stats);
+    TEST_RUN(test_subscriber_limit);
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_sensor_sim.c
+ * @brief Sensor drivers against register-level models on simulated bus, fault injection and bus supervision
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "sensors.h"
+#include "sensor_sim.h"
+#include "i2c_bus.h"
+#include "i2c_supervisor.h"
+#include "cmsis_os2.h"
+#include <pthread.h>
+
+static uint32_t readings;
+static sensor_source_t reading_sources[SENSOR_MAX_CHANNELS];
+static sensor_data_type_t reading_types[SENSOR_MAX_CHANNELS];
+
+static void reading_handler(sensor_data_type_t type, sensor_source_t source, int32_t value) {
+    if (readings < SENSOR_MAX_CHANNELS) {
+        reading_types[readings] = type;
+        reading_sources[readings] = source;
+    }
+    readings++;
+}
+
+static const sensor_driver_t* driver_of(sensor_source_t source) {
+    uint32_t count;
+    const sensor_driver_t* drivers = sensor_drivers(&count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (drivers[i].source == source) {
+            return &drivers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Waits nominal conversion time and polls result the way acquisition does
+ */
+static sensor_fetch_status_t fetch_converted(const sensor_driver_t* driver) {
+    osDelay(driver->conversion_time_ms);
+    sensor_fetch_status_t status;
+    for (uint32_t waited = 0; (status = driver->fetch_result(reading_handler)) == SENSOR_FETCH_NOT_READY
+        && waited < driver->conversion_time_ms; waited += 5) {
+        osDelay(5);
+    }
+    return status;
+}
+
+static void test_drivers_registered(void) {
+    uint32_t count;
+    sensor_drivers(&count);
+    TEST_CHECK_EQ(count, SENSOR_SOURCE_COUNT);
+    for (sensor_source_t source = 0; source < SENSOR_SOURCE_COUNT; source++) {
+        const sensor_driver_t* driver = driver_of(source);
+        TEST_CHECK(driver != NULL);
+        TEST_CHECK(i2c_bus_probe(driver->bus, driver->addr, 1));
+    }
+    TEST_CHECK(!i2c_bus_probe(I2C_BUS_SENSORS, 0x7F, 1));
+}
+
+static void test_drivers_convert(void) {
+    for (sensor_source_t source = 0; source < SENSOR_SOURCE_COUNT; source++) {
+        const sensor_driver_t* driver = driver_of(source);
+        TEST_CHECK(driver->init == NULL || driver->init());
+        TEST_CHECK(driver->start_conversion());
+        readings = 0;
+        TEST_CHECK_EQ(fetch_converted(driver), SENSOR_FETCH_OK);
+        TEST_CHECK_EQ(readings, driver->channel_count);
+        for (uint8_t c = 0; c < driver->channel_count; c++) {
+            TEST_CHECK_EQ(reading_sources[c], source);
+            TEST_CHECK_EQ(reading_types[c], driver->channels[c].type);
+        }
+    }
+}
+
+static void test_ready_polling(void) {
+    const sensor_driver_t* driver = driver_of(SENSOR_SOURCE_AGS02MA);
+    TEST_CHECK(driver->ready_polling);
+    TEST_CHECK(driver->start_conversion());
+    readings = 0;
+    TEST_CHECK_EQ(driver->fetch_result(reading_handler), SENSOR_FETCH_NOT_READY);
+    TEST_CHECK_EQ(readings, 0);
+    TEST_CHECK_EQ(fetch_converted(driver), SENSOR_FETCH_OK);
+}
+
+static void test_corrupt_data(void) {
+    const sensor_driver_t* driver = driver_of(SENSOR_SOURCE_AHT20);
+    const i2c_sim_faults_t corrupt = {.corrupt_every = 1};
+    const i2c_sim_faults_t none = {0};
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &corrupt);
+    TEST_CHECK(driver->start_conversion());
+    readings = 0;
+    TEST_CHECK_EQ(fetch_converted(driver), SENSOR_FETCH_CRC_ERROR);
+    TEST_CHECK_EQ(readings, 0);
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &none);
+}
+
+static void test_isolation(void) {
+    const sensor_driver_t* driver = driver_of(SENSOR_SOURCE_AHT20);
+    const i2c_sim_faults_t stall = {.stall_every = 1};
+    const i2c_sim_faults_t none = {0};
+    uint8_t data[7];
+
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &stall);
+    for (uint8_t i = 0; i < I2C_SUPERVISOR_FAILURE_LIMIT; i++) {
+        TEST_CHECK_EQ(i2c_bus_receive(driver->bus, I2C_PRIORITY_NORMAL, driver->addr, data, sizeof(data)), I2C_STATUS_TIMEOUT);
+    }
+    TEST_CHECK_EQ(i2c_bus_receive(driver->bus, I2C_PRIORITY_NORMAL, driver->addr, data, sizeof(data)), I2C_STATUS_ISOLATED);
+
+    /* Other devices on the bus are not affected */
+    const sensor_driver_t* other = driver_of(SENSOR_SOURCE_BMP280);
+    TEST_CHECK(i2c_bus_probe(other->bus, other->addr, 1));
+
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &none);
+    osDelay(I2C_SUPERVISOR_BACKOFF_MIN_MS + 10);
+    TEST_CHECK_EQ(i2c_bus_receive(driver->bus, I2C_PRIORITY_NORMAL, driver->addr, data, sizeof(data)), I2C_STATUS_OK);
+}
+
+static void test_stuck_bus_recovery(void) {
+    const sensor_driver_t* stuck = driver_of(SENSOR_SOURCE_AGS02MA);
+    const sensor_driver_t* other = driver_of(SENSOR_SOURCE_AHT20);
+    const i2c_sim_faults_t hold = {.hold_sda_every = 1};
+    const i2c_sim_faults_t none = {0};
+    uint8_t data[7];
+
+    sensor_sim_set_faults(SENSOR_SOURCE_AGS02MA, &hold);
+    TEST_CHECK(i2c_bus_receive(stuck->bus, I2C_PRIORITY_NORMAL, stuck->addr, data, 5) != I2C_STATUS_OK);
+    sensor_sim_set_faults(SENSOR_SOURCE_AGS02MA, &none);
+    TEST_CHECK_EQ(i2c_bus_receive(other->bus, I2C_PRIORITY_NORMAL, other->addr, data, sizeof(data)), I2C_STATUS_OK);
+}
+
+static pthread_barrier_t status_barrier;
+static i2c_status_t stalled_caller_status;
+
+static void* stalled_caller(void* argument) {
+    const sensor_driver_t* driver = driver_of(SENSOR_SOURCE_AHT20);
+    uint8_t data[7];
+    i2c_bus_receive(driver->bus, I2C_PRIORITY_NORMAL, driver->addr, data, sizeof(data));
+    pthread_barrier_wait(&status_barrier);
+    /* Main task made a successful transfer meanwhile */
+    pthread_barrier_wait(&status_barrier);
+    stalled_caller_status = i2c_bus_last_status(driver->bus);
+    return NULL;
+}
+
+/**
+ * @brief Tasks sharing a bus see status of their own last transfer
+ */
+static void test_last_status_per_caller(void) {
+    const sensor_driver_t* other = driver_of(SENSOR_SOURCE_BMP280);
+    const i2c_sim_faults_t stall = {.stall_every = 1};
+    const i2c_sim_faults_t none = {0};
+    uint8_t data[1];
+    pthread_t thread;
+
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &stall);
+    pthread_barrier_init(&status_barrier, NULL, 2);
+    TEST_CHECK_EQ(pthread_create(&thread, NULL, stalled_caller, NULL), 0);
+    pthread_barrier_wait(&status_barrier);
+    TEST_CHECK_EQ(i2c_bus_mem_read(other->bus, I2C_PRIORITY_NORMAL, other->addr, 0xD0, data, sizeof(data)), I2C_STATUS_OK);
+    pthread_barrier_wait(&status_barrier);
+    pthread_join(thread, NULL);
+    pthread_barrier_destroy(&status_barrier);
+    sensor_sim_set_faults(SENSOR_SOURCE_AHT20, &none);
+
+    TEST_CHECK_EQ(stalled_caller_status, I2C_STATUS_TIMEOUT);
+    TEST_CHECK_EQ(i2c_bus_last_status(other->bus), I2C_STATUS_OK);
+}
+
+static void test_hot_plug(void) {
+    const sensor_driver_t* driver = driver_of(SENSOR_SOURCE_BMP280);
+    sensor_sim_set_attached(SENSOR_SOURCE_BMP280, false);
+    TEST_CHECK(!i2c_bus_probe(driver->bus, driver->addr, 1));
+    sensor_sim_set_attached(SENSOR_SOURCE_BMP280, true);
+    TEST_CHECK(i2c_bus_probe(driver->bus, driver->addr, 1));
+}
+
+int main(void) {
+    i2c_bus_init();
+    sensor_sim_init();
+
+    TEST_RUN(test_drivers_registered);
+    TEST_RUN(test_drivers_convert);
+    TEST_RUN(test_ready_polling);
+    TEST_RUN(test_corrupt_data);
+    TEST_RUN(test_isolation);
+    TEST_RUN(test_stuck_bus_recovery);
+    TEST_RUN(test_last_status_per_caller);
+    TEST_RUN(test_hot_plug);
+    return 0;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file test_tslog.c
+ * @brief Timestamped log on RAM flash model, ring wrap, cursor walks, timestamp seek, zone maps and reopening after reboot
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "tslog.h"
+#include "memory.h"
+#include "memory_layout.h"
+#include <string.h>
+
+#define LOG_SECTORS 2
+#define CHUNK 16
+#define REOPEN_SECTOR 4
+#define LAYOUT_SECTOR (REOPEN_SECTOR + LOG_SECTORS)
+
+static tslog_t log;
+static tslog_cursor_t cursor;
+
+static uint32_t entries_per_sector(void) {
+    return memory.sector_size / sizeof(memory_entry_t);
+}
+
+static void append_range(uint32_t first, uint32_t last) {
+    for (uint32_t timestamp = first; timestamp <= last; timestamp++) {
+        memory_entry_t entry = {.timestamp = timestamp, .value = (int32_t)timestamp * 10};
+        tslog_append(&log, &entry);
+    }
+}
+
+/**
+ * @brief Walks log forward from the oldest entry, checks that timestamps are consecutive
+ */
+static uint32_t walk_forward(uint32_t* oldest) {
+    int32_t values[CHUNK];
+    uint32_t timestamps[CHUNK];
+    uint32_t total = 0;
+    uint16_t loaded;
+    tslog_cursor_init(&cursor, &log);
+    tslog_cursor_rewind(&cursor);
+    while ((loaded = tslog_cursor_next(&cursor, values, timestamps, CHUNK)) > 0) {
+        for (uint16_t i = 0; i < loaded; i++) {
+            if (total == 0) {
+                *oldest = timestamps[i];
+            }
+            TEST_CHECK_EQ(timestamps[i], *oldest + total);
+            TEST_CHECK_EQ(values[i], (int32_t)timestamps[i] * 10);
+            total++;
+        }
+    }
+    return total;
+}
+
+static uint32_t walk_backward(uint32_t* oldest) {
+    int32_t values[CHUNK];
+    uint32_t timestamps[CHUNK];
+    uint32_t total = 0;
+    uint16_t loaded;
+    tslog_cursor_init(&cursor, &log);
+    while ((loaded = tslog_cursor_prev(&cursor, values, timestamps, CHUNK)) > 0) {
+        total += loaded;
+        *oldest = timestamps[loaded - 1];
+    }
+    return total;
+}
+
+static void test_empty(void) {
+    int32_t value;
+    tslog_cursor_init(&cursor, &log);
+    TEST_CHECK_EQ(tslog_cursor_next(&cursor, &value, NULL, 1), 0);
+    TEST_CHECK(!tslog_cursor_seek(&cursor, 1));
+}
+
+static void test_partial_fill(void) {
+    uint32_t count = entries_per_sector() + entries_per_sector() / 2;
+    uint32_t oldest = 0;
+    append_range(1, count);
+    TEST_CHECK_EQ(walk_forward(&oldest), count);
+    TEST_CHECK_EQ(oldest, 1);
+    TEST_CHECK_EQ(walk_backward(&oldest), count);
+    TEST_CHECK_EQ(oldest, 1);
+}
+
+static void test_wrapped(void) {
+    uint32_t capacity = entries_per_sector() * LOG_SECTORS;
+    uint32_t oldest = 0;
+    /* Ring is full, the next append reclaims the oldest sector */
+    append_range(entries_per_sector() + entries_per_sector() / 2 + 1, capacity);
+    TEST_CHECK(tslog_append_will_erase(&log));
+    TEST_CHECK(tslog_append_will_reclaim(&log));
+    TEST_CHECK_EQ(walk_forward(&oldest), capacity);
+    TEST_CHECK_EQ(oldest, 1);
+
+    append_range(capacity + 1, capacity * 2);
+    TEST_CHECK_EQ(walk_forward(&oldest), capacity);
+    TEST_CHECK_EQ(oldest, capacity + 1);
+    TEST_CHECK_EQ(walk_backward(&oldest), capacity);
+    TEST_CHECK_EQ(oldest, capacity + 1);
+}
+
+static void test_seek(void) {
+    uint32_t capacity = entries_per_sector() * LOG_SECTORS;
+    int32_t value;
+    uint32_t timestamp;
+    tslog_cursor_init(&cursor, &log);
+
+    TEST_CHECK(!tslog_cursor_seek(&cursor, capacity));
+    TEST_CHECK(tslog_cursor_seek(&cursor, capacity + 1));
+    TEST_CHECK_EQ(tslog_cursor_next(&cursor, &value, &timestamp, 1), 1);
+    TEST_CHECK_EQ(timestamp, capacity + 1);
+
+    TEST_CHECK(tslog_cursor_seek(&cursor, capacity + capacity / 2));
+    TEST_CHECK_EQ(tslog_cursor_next(&cursor, &value, &timestamp, 1), 1);
+    TEST_CHECK_EQ(timestamp, capacity + capacity / 2);
+
+    /* Position is kept across tell and restore */
+    tslog_pos_t pos = tslog_cursor_tell(&cursor);
+    TEST_CHECK_EQ(tslog_cursor_next(&cursor, &value, &timestamp, 1), 1);
+    tslog_cursor_restore(&cursor, pos);
+    TEST_CHECK_EQ(tslog_cursor_next(&cursor, &value, &timestamp, 1), 1);
+    TEST_CHECK_EQ(timestamp, capacity + capacity / 2 + 1);
+}
+
+static void test_find_max(void) {
+    uint32_t capacity = entries_per_sector() * LOG_SECTORS;
+    memory_entry_t found;
+    tslog_cursor_init(&cursor, &log);
+    TEST_CHECK(tslog_find_max(&cursor, capacity + 1, capacity + 100, &found));
+    TEST_CHECK_EQ(found.timestamp, capacity + 100);
+    TEST_CHECK_EQ(found.value, (capacity + 100) * 10);
+}
+
+static void test_scan(void) {
+    uint32_t capacity = entries_per_sector() * LOG_SECTORS;
+    uint32_t oldest = 0;
+    tslog_init(&log, 0, memory.sector_size * LOG_SECTORS);
+    tslog_scan(&log);
+    TEST_CHECK_EQ(walk_forward(&oldest), capacity);
+    TEST_CHECK_EQ(oldest, capacity + 1);
+}
+
+/**
+ * @brief Initializes log over flash left by the previous run, as archivist does at boot
+ */
+static void reopen(uint32_t sector, uint32_t sectors) {
+    tslog_init(&log, memory.sector_size * sector, memory.sector_size * sectors);
+    tslog_scan(&log);
+}
+
+/**
+ * @brief Reopened log continues after its newest entry, also when the ring is full up to a sector boundary
+ */
+static void test_reopen(void) {
+    const uint32_t per_sector = entries_per_sector();
+    uint32_t oldest = 0;
+    tslog_init(&log, memory.sector_size * REOPEN_SECTOR, memory.sector_size * LOG_SECTORS);
+    /* Wrapped once, the newest entries end within the first sector */
+    append_range(1, 2 * per_sector + 5);
+    reopen(REOPEN_SECTOR, LOG_SECTORS);
+    TEST_CHECK_EQ(walk_forward(&oldest), per_sector + 5);
+    TEST_CHECK_EQ(oldest, per_sector + 1);
+
+    /* No free slot is left and the newest entry ends the first sector, the second one is reclaimed next */
+    append_range(2 * per_sector + 6, 3 * per_sector);
+    reopen(REOPEN_SECTOR, LOG_SECTORS);
+    TEST_CHECK_EQ(log.write_addr, memory.sector_size * (REOPEN_SECTOR + 1));
+    TEST_CHECK(tslog_append_will_reclaim(&log));
+    TEST_CHECK_EQ(walk_forward(&oldest), 2 * per_sector);
+    TEST_CHECK_EQ(oldest, per_sector + 1);
+
+    append_range(3 * per_sector + 1, 3 * per_sector + 1);
+    TEST_CHECK_EQ(walk_forward(&oldest), per_sector + 1);
+    TEST_CHECK_EQ(oldest, 2 * per_sector + 1);
+    TEST_CHECK_EQ(walk_backward(&oldest), per_sector + 1);
+    TEST_CHECK_EQ(oldest, 2 * per_sector + 1);
+}
+
+/**
+ * @brief Zone maps of a reopened log are rebuilt from stored pages, queries skip pages as before the reboot
+ */
+static void test_zone_rebuild(void) {
+    const uint32_t per_sector = entries_per_sector();
+    tslog_zone_t zones[TSLOG_MAX_PAGES];
+    memory_entry_t found;
+    memcpy(zones, log.zones, sizeof(zones));
+
+    tslog_init(&log, memory.sector_size * REOPEN_SECTOR, memory.sector_size * LOG_SECTORS);
+    tslog_cursor_init(&cursor, &log);
+    TEST_CHECK(!tslog_find_max(&cursor, 0, UINT32_MAX, &found));
+    tslog_scan(&log);
+    TEST_CHECK(memcmp(zones, log.zones, sizeof(zones)) == 0);
+
+    tslog_cursor_init(&cursor, &log);
+    TEST_CHECK(tslog_find_max(&cursor, 0, UINT32_MAX, &found));
+    TEST_CHECK_EQ(found.timestamp, 3 * per_sector + 1);
+    TEST_CHECK(tslog_find_first_above(&cursor, 0, (int32_t)(2 * per_sector + 100) * 10, &found));
+    TEST_CHECK_EQ(found.timestamp, 2 * per_sector + 101);
+}
+
+/**
+ * @brief Flash without layout marker, as left by firmware before it, is erased once and kept afterwards
+ */
+static void test_layout_mismatch(void) {
+    const uint32_t marker_addr = memory.sector_size * LAYOUT_SECTOR;
+    uint32_t oldest = 0;
+    TEST_CHECK(!memory_layout_check(marker_addr, 1, LAYOUT_SECTOR + 1));
+    reopen(REOPEN_SECTOR, LOG_SECTORS);
+    TEST_CHECK_EQ(walk_forward(&oldest), 0);
+
+    append_range(1, 10);
+    TEST_CHECK(memory_layout_check(marker_addr, 1, LAYOUT_SECTOR + 1));
+    reopen(REOPEN_SECTOR, LOG_SECTORS);
+    TEST_CHECK_EQ(walk_forward(&oldest), 10);
+
+    TEST_CHECK(!memory_layout_check(marker_addr, 2, LAYOUT_SECTOR + 1));
+    reopen(REOPEN_SECTOR, LOG_SECTORS);
+    TEST_CHECK_EQ(walk_forward(&oldest), 0);
+}
+
+int main(void) {
+    memory_init_driver();
+    memory.init();
+    tslog_init(&log, 0, memory.sector_size * LOG_SECTORS);
+
+    TEST_RUN(test_empty);
+    TEST_RUN(test_partial_fill);
+    TEST_RUN(test_wrapped);
+    TEST_RUN(test_seek);
+    TEST_RUN(test_find_max);
+    TEST_RUN(test_scan);
+    TEST_RUN(test_reopen);
+    TEST_RUN(test_zone_rebuild);
+    TEST_RUN(test_layout_mismatch);
+    return 0;
+}
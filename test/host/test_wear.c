@@ -0,0 +1,115 @@
+/**
+ * @file test_wear.c
+ * @brief Wear counters on RAM flash model, restore after reboot, persist sector switch and save threshold
+ *
+ * @author Andrii Horbul (andreyhorbggwp@gmail.com)
+ */
+
+#include "test.h"
+#include "wear.h"
+#include "memory.h"
+#include <string.h>
+
+#define TRACKED_SECTORS 4
+#define PERSIST_SECTOR 2
+#define WRITE_SIZE 256
+
+static void (*flash_erase_sector)(uint32_t addr);
+static uint32_t persist_erases;
+static uint8_t data[WRITE_SIZE];
+
+static bool sector_is_erased(uint32_t sector) {
+    uint32_t word;
+    memory.read((uint8_t*)&word, sector * memory.sector_size, sizeof(word));
+    return word == 0xFFFFFFFF;
+}
+
+/**
+ * @brief Erases sector, a persist sector may only be erased while the other one keeps the previous record
+ */
+static void erase_sector_checked(uint32_t addr) {
+    flash_erase_sector(addr);
+    uint32_t sector = addr / memory.sector_size;
+    if (sector == PERSIST_SECTOR || sector == PERSIST_SECTOR + 1) {
+        persist_erases++;
+        TEST_CHECK(!sector_is_erased((sector == PERSIST_SECTOR) ? PERSIST_SECTOR + 1 : PERSIST_SECTOR));
+    }
+}
+
+/**
+ * @brief Restarts counting over flash left by the previous run, as archivist does at boot
+ */
+static void reboot(void) {
+    memory_init_driver();
+    flash_erase_sector = memory.erase_sector;
+    memory.erase_sector = erase_sector_checked;
+    wear_init(TRACKED_SECTORS, PERSIST_SECTOR * memory.sector_size);
+}
+
+static uint32_t program_bytes(void) {
+    uint32_t payload;
+    uint32_t programmed;
+    wear_get_bytes(&payload, &programmed);
+    return programmed;
+}
+
+/**
+ * @brief Counters saved on erase are restored after reboot
+ */
+static void test_restore(void) {
+    memory.erase_sector(0);
+    memory.write(data, 0, sizeof(data));
+    wear_persist();
+    uint32_t programmed = program_bytes();
+    reboot();
+    TEST_CHECK_EQ(program_bytes(), programmed);
+}
+
+/**
+ * @brief Records fill one persist sector and go on in the other one, every switch keeps the latest record
+ */
+static void test_sector_switch(void) {
+    persist_erases = 0;
+    while (persist_erases == 0) {
+        wear_persist();
+    }
+    TEST_CHECK(!sector_is_erased(PERSIST_SECTOR));
+    TEST_CHECK(!sector_is_erased(PERSIST_SECTOR + 1));
+    uint32_t programmed = program_bytes();
+    reboot();
+    TEST_CHECK_EQ(program_bytes(), programmed);
+
+    /* Records continue in the second sector after reboot, the first one is erased when it is full */
+    persist_erases = 0;
+    while (persist_erases == 0) {
+        wear_persist();
+    }
+    programmed = program_bytes();
+    reboot();
+    TEST_CHECK_EQ(program_bytes(), programmed);
+}
+
+/**
+ * @brief Writes without erase are saved once enough bytes are programmed
+ */
+static void test_byte_threshold(void) {
+    uint32_t programmed = program_bytes();
+    memory.erase_sector(0);
+    for (uint32_t bytes = 0; bytes < WEAR_PERSIST_BYTES; bytes += WRITE_SIZE) {
+        memory.write(data, bytes % memory.sector_size, sizeof(data));
+    }
+    reboot();
+    TEST_CHECK(program_bytes() - programmed >= WEAR_PERSIST_BYTES);
+}
+
+int main(void) {
+    memory_init_driver();
+    memory.init();
+    memset(data, 0, sizeof(data));
+    reboot();
+
+    TEST_RUN(test_restore);
+    TEST_RUN(test_sector_switch);
+    TEST_RUN(test_byte_threshold);
+    return 0;
+}